@@ -0,0 +1,461 @@
+// CPU-only microbenchmarks for the math / geometry hot paths.
+// No GL context or camera is needed (ImGui runs headless, without a
+// renderer); results are written as JSON so runs from different commits
+// can be diffed.
+//
+// Heap allocations are counted per op (see alloc_counter.hpp). Steady-state
+// paths are expected to allocate nothing after the warm-up call; one that
+// does is reported and makes the run exit with status 2.
+//
+// Usage: micro_bench [--filter substr] [--min-time seconds] [--out results.json]
+
+#include "mesh.hpp"
+#include "object.hpp"
+#include "scene.hpp"
+#include "ar_tracker.hpp"
+#include "pose_solver.hpp"
+#include "quad_detector.hpp"
+#include "simulation.hpp"
+#include "body_inspector.hpp"
+#include "alloc_counter.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // Keep the optimiser from discarding a computed value
+  template <class T>
+  inline void keep(const T &v)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(v) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &v;
+#endif
+  }
+
+  // Make the compiler assume v changed, so work on it cannot be hoisted
+  template <class T>
+  inline void touch(T &v)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : "+m"(v) : : "memory");
+#else
+    keep(v);
+#endif
+  }
+
+  struct Result
+  {
+    std::string name;
+    long long iterations{0};
+    double nsPerOp{0}, nsMin{0}, nsMax{0};
+    double itemsPerOp{1};
+    double allocsPerOp{0};
+    double exemptPerOp{0}; // inside alloc::Exempt (named OpenCV calls)
+  };
+
+  struct Runner
+  {
+    std::string filter;
+    double minTime = 0.5;
+    std::vector<Result> results;
+    std::vector<std::string> allocFailures;
+
+    // fn runs `n` iterations; time per iteration is the median over batches.
+    // steady: fn must not allocate once warmed up, outside alloc::Exempt scopes
+    void run(const std::string &name, double itemsPerOp,
+             const std::function<void(long long n)> &fn, bool steady = false)
+    {
+      if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+      using clock = std::chrono::steady_clock;
+
+      fn(1); // warm-up
+      long long n = 1;
+      for (;;) // grow the batch until it takes ~10 ms
+      {
+        auto t0 = clock::now();
+        fn(n);
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        if (s > 0.01 || n >= (1ll << 30))
+          break;
+        n *= 4;
+      }
+
+      std::vector<double> samples;
+      long long total = 0;
+      std::uint64_t allocs = 0, exempt = 0;
+      auto start = clock::now();
+      do
+      {
+        alloc::Counts mark = alloc::thread(), exMark = alloc::exempted();
+        auto t0 = clock::now();
+        fn(n);
+        auto t1 = clock::now();
+        allocs += alloc::since(mark).calls; // before push_back, which may allocate
+        exempt += alloc::exempted().calls - exMark.calls;
+        samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / n);
+        total += n;
+      } while (samples.size() < 5 ||
+               std::chrono::duration<double>(clock::now() - start).count() < minTime);
+
+      std::sort(samples.begin(), samples.end());
+      Result r;
+      r.name = name;
+      r.iterations = total;
+      r.nsPerOp = samples[samples.size() / 2];
+      r.nsMin = samples.front();
+      r.nsMax = samples.back();
+      r.itemsPerOp = itemsPerOp;
+      r.allocsPerOp = double(allocs) / total;
+      r.exemptPerOp = double(exempt) / total;
+      std::fprintf(stderr, "%-32s %14.1f ns/op %10.3f allocs/op %8.1f exempt  (%lld iters)%s\n",
+                   name.c_str(), r.nsPerOp, r.allocsPerOp, r.exemptPerOp, total,
+                   steady && allocs ? "  ALLOCATES" : "");
+      if (steady && allocs)
+        allocFailures.push_back(name);
+      results.push_back(r);
+    }
+
+    void writeJson(FILE *f) const
+    {
+      std::fprintf(f, "{\n  \"benchmarks\": [\n");
+      for (std::size_t i = 0; i < results.size(); ++i)
+      {
+        const Result &r = results[i];
+        std::fprintf(f,
+                     "    {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, "
+                     "\"ns_min\": %.3f, \"ns_max\": %.3f, \"items_per_second\": %.1f, "
+                     "\"allocs_per_op\": %.3f, \"exempt_allocs_per_op\": %.3f}%s\n",
+                     r.name.c_str(), r.iterations, r.nsPerOp, r.nsMin, r.nsMax,
+                     r.itemsPerOp * 1e9 / r.nsPerOp, r.allocsPerOp, r.exemptPerOp,
+                     i + 1 < results.size() ? "," : "");
+      }
+      std::fprintf(f, "  ]\n}\n");
+    }
+  };
+
+  // N bodies in a shallow hierarchy: a few roots, everything else orbits an
+  // earlier body so orbitTarget lookups are exercised like the real scene
+  struct Bodies
+  {
+    std::vector<std::unique_ptr<Object>> objects;
+    Scene scene;
+
+    explicit Bodies(std::size_t n)
+    {
+      std::mt19937 rng(42);
+      std::uniform_real_distribution<float> u(0.0f, 1.0f);
+      objects.reserve(n);
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        auto o = std::make_unique<Object>(); // no assets: update cost only
+        o->localScale = glm::vec3(0.01f + 0.1f * u(rng));
+        o->spinSpeed = glm::radians(10.0f + 90.0f * u(rng));
+        if (i > 0)
+        {
+          o->orbitRadius = 0.05f + u(rng);
+          o->orbitSpeed = glm::radians(5.0f + 60.0f * u(rng));
+          o->orbitAxis = glm::normalize(glm::vec3(u(rng) - 0.5f, 1.0f, u(rng) - 0.5f));
+          o->orbitTarget = objects[std::size_t(u(rng) * std::min<std::size_t>(i, 64))].get();
+        }
+        scene.add(o.get());
+        objects.push_back(std::move(o));
+      }
+    }
+  };
+}
+
+int main(int argc, char **argv)
+{
+  Runner run;
+  const char *outPath = nullptr;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+      run.filter = argv[++i];
+    else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc)
+      run.minTime = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--out") && i + 1 < argc)
+      outPath = argv[++i];
+  }
+
+  // ---- mesh generation (CPU side of Mesh::sphere) ----
+  for (int seg : {32, 64, 128})
+  {
+    std::vector<float> verts;
+    std::vector<unsigned> idx;
+    run.run("Mesh::sphereGeometry/" + std::to_string(seg), 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                Mesh::sphereGeometry(seg, seg, verts, idx);
+                keep(verts.data());
+              } });
+  }
+
+  // ---- single body update ----
+  {
+    Object parent, body;
+    body.spinSpeed = 1.0f;
+    body.orbitRadius = 0.4f;
+    body.orbitSpeed = 0.5f;
+    body.orbitTarget = &parent;
+    run.run("Object::update", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                body.advance(1.0f / 60.0f);
+                body.updateWorld(parent.frame);
+                keep(body.model);
+              } }, true);
+  }
+
+  // ---- whole-scene update ----
+  for (std::size_t count : {std::size_t(3), std::size_t(1000), std::size_t(100000), std::size_t(1000000)})
+  {
+    Bodies b(count);
+    run.run("Scene::update/" + std::to_string(count), double(count), [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                b.scene.update(1.0f / 60.0f, 0.0f);
+                keep(b.objects.back()->model);
+              } }, true);
+  }
+
+  // ---- static scene: nothing moves, so no world matrix is rebuilt ----
+  {
+    Bodies b(100000);
+    for (auto &o : b.objects)
+      o->spinSpeed = o->orbitSpeed = 0.0f;
+    b.scene.update(0.0f, 0.0f); // initial world matrices
+    run.run("Scene::update/static/100000", 100000.0, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                b.scene.update(1.0f / 60.0f, 0.0f);
+                keep(b.objects.back()->model);
+              } }, true);
+  }
+
+  // ---- inspector UI over a large scene: one headless ImGui frame ----
+  {
+    Bodies b(100000);
+    for (std::size_t i = 0; i < b.objects.size(); ++i)
+      b.objects[i]->name = "body " + std::to_string(i);
+    Simulation sim(b.scene); // not started: draw() only posts commands
+    BodyInspector inspector;
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(1280, 720);
+    io.DeltaTime = 1.0f / 60.0f;
+    unsigned char *px;
+    int fw, fh;
+    io.Fonts->GetTexDataAsRGBA32(&px, &fw, &fh); // atlas built once, never uploaded
+    run.run("BodyInspector::draw/100000", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                ImGui::NewFrame();
+                {
+                  auto lk = sim.lockParams();
+                  inspector.draw(b.scene, sim);
+                }
+                ImGui::Render();
+                keep(ImGui::GetDrawData());
+              } });
+    ImGui::DestroyContext();
+  }
+
+  // ---- render-thread side of a frame: interpolated models from the sim thread ----
+  {
+    Bodies b(1000);
+    Simulation sim(b.scene); // its own thread's allocations are not counted here
+    sim.start();
+    std::vector<glm::mat4> models;
+    run.run("Frame::sample+snapshot/1000", 1000.0, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                const std::vector<glm::mat4> &m = sim.sample();
+                models.assign(m.begin(), m.end());
+                keep(models.data());
+              } }, true);
+    sim.stop();
+  }
+
+  // ---- tracker math ----
+  {
+    cv::Vec3d rvec(0.3, -0.2, 0.1), tvec(0.02, -0.01, 0.35);
+    run.run("ARTracker::cvToGlm", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                touch(rvec);
+                glm::mat4 V = ARTracker::cvToGlm(rvec, tvec);
+                keep(V);
+              } }, true);
+
+    cv::Mat K = (cv::Mat_<double>(3, 3) << 576, 0, 320, 0, 576, 240, 0, 0, 1);
+    run.run("makeProj", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                touch(K);
+                glm::mat4 P = makeProj(K, 640, 480, 0.01f, 100.f);
+                keep(P);
+              } }, true);
+  }
+
+  // ---- square-marker pose solving (8 markers per frame) ----
+  {
+    cv::Mat K = (cv::Mat_<double>(3, 3) << 576, 0, 320, 0, 576, 240, 0, 0, 1);
+    cv::Mat dist = cv::Mat::zeros(1, 5, CV_64F);
+    const float len = 0.08f, h = len / 2;
+    std::vector<cv::Point3f> obj = {{-h, h, 0}, {h, h, 0}, {h, -h, 0}, {-h, -h, 0}};
+    std::vector<int> ids;
+    std::vector<std::vector<cv::Point2f>> corners;
+    for (int m = 0; m < 8; ++m)
+    {
+      cv::Vec3d rvec(0.4 - 0.1 * m, 0.2, 0.05 * m), tvec(-0.12 + 0.03 * m, 0.02, 0.4);
+      std::vector<cv::Point2f> img;
+      cv::projectPoints(obj, rvec, tvec, K, dist, img);
+      ids.push_back(m);
+      corners.push_back(img);
+    }
+    PoseSolver solver(K, dist, len);
+    std::vector<MarkerPose> poses;
+    run.run("PoseSolver::solve/cold", double(ids.size()), [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                solver.reset();
+                solver.solve(ids, corners, poses);
+                keep(poses.data());
+              } }, true);
+    run.run("PoseSolver::solve/warm", double(ids.size()), [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                solver.solve(ids, corners, poses);
+                keep(poses.data());
+              } }, true);
+  }
+
+  // ---- marker candidates: stock ArUco vs. QuadDetector on one 640x480 frame ----
+  {
+    const auto dict = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+    cv::Mat gray(480, 640, CV_8UC1), marker;
+    cv::randu(gray, 60, 200); // textured background: plenty of contours
+    cv::aruco::generateImageMarker(dict, 0, 160, marker, 1);
+    cv::copyMakeBorder(marker, marker, 20, 20, 20, 20, cv::BORDER_CONSTANT, 255);
+    marker.copyTo(gray(cv::Rect(200, 120, marker.cols, marker.rows)));
+
+    cv::Mat bin;
+    run.run("Threshold/cv::adaptiveThreshold/640x480", double(gray.total()), [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                cv::adaptiveThreshold(gray, bin, 255, cv::ADAPTIVE_THRESH_MEAN_C,
+                                      cv::THRESH_BINARY_INV, 21, 7);
+                keep(bin.data);
+              } });
+    QuadDetector quads(dict);
+    run.run("Threshold/QuadDetector/640x480", double(gray.total()), [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                quads.threshold(gray);
+                keep(quads.binary().data);
+              } });
+
+    cv::aruco::ArucoDetector detector(dict);
+    std::vector<std::vector<cv::Point2f>> corners, rejected;
+    std::vector<int> ids;
+    run.run("Detect/ArucoDetector/640x480", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                detector.detectMarkers(gray, corners, ids, rejected);
+                keep(ids.data());
+              } });
+    run.run("Detect/QuadDetector/640x480", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                quads.detect(gray, corners, ids);
+                keep(ids.data());
+              } });
+
+    // The per-frame tracker path (grabFrame() minus capture and upload):
+    // grey conversion, pyramid, flow or detection, pose. Two frames a pixel
+    // apart, so flow has motion to follow and detection still runs every
+    // maxInterval frames
+    cv::Mat frames[2];
+    cv::cvtColor(gray, frames[0], cv::COLOR_GRAY2BGR);
+    cv::Mat shift = (cv::Mat_<double>(2, 3) << 1, 0, 1, 0, 1, 0);
+    cv::warpAffine(frames[0], frames[1], shift, frames[0].size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    cv::Mat K = (cv::Mat_<double>(3, 3) << 576, 0, 320, 0, 576, 240, 0, 0, 1);
+    for (bool flow : {false, true})
+    {
+      ARTracker tracker(K, gray.size());
+      tracker.track.enabled = flow;
+      long long frame = 0;
+      run.run(flow ? "Frame/ARTracker::process/flow" : "Frame/ARTracker::process/detect", 1,
+              [&](long long n)
+              {
+                for (long long i = 0; i < n; ++i)
+                  keep(tracker.process(frames[frame++ & 1]));
+              }, true);
+    }
+  }
+
+  // ---- per-draw normal matrix (Object::draw / RenderQueue) ----
+  {
+    glm::mat4 MV = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.1f, 0.2f, -0.5f)),
+                               0.7f, glm::normalize(glm::vec3(1, 2, 3)));
+    MV = glm::scale(MV, glm::vec3(0.08f));
+    run.run("Object::normalMatrix", 1, [&](long long n)
+            {
+              for (long long i = 0; i < n; ++i)
+              {
+                touch(MV);
+                glm::mat3 N = Object::normalMatrix(MV);
+                keep(N);
+              } }, true);
+  }
+
+  FILE *out = outPath ? std::fopen(outPath, "w") : stdout;
+  if (!out)
+  {
+    std::fprintf(stderr, "cannot write %s\n", outPath);
+    return 1;
+  }
+  run.writeJson(out);
+  if (out != stdout)
+    std::fclose(out);
+
+  for (const std::string &name : run.allocFailures)
+    std::fprintf(stderr, "steady-state path allocates: %s\n", name.c_str());
+  return run.allocFailures.empty() ? 0 : 2;
+}
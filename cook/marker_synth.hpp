@@ -0,0 +1,184 @@
+#pragma once
+// Synthetic ArUco sequences with scripted ground-truth 6-DoF trajectories.
+// Renders a DICT_6X6_250 marker (with its white quiet zone) into a cluttered
+// background through the pinhole model, then applies lighting drift, blur,
+// sensor noise and random occluders.
+
+#include <opencv2/aruco.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+struct SynthParams
+{
+  int width = 640, height = 480;
+  float markerLen = 0.08f;  // metres, matches ARTracker default
+  int markerId = 0;
+  int frames = 300;
+  float fps = 30.0f;
+  float speed = 1.0f;       // trajectory time scale (motion magnitude)
+  float blurSigma = 0.0f;   // px
+  float noiseSigma = 0.0f;  // grey levels
+  float lighting = 0.0f;    // 0..1 gain swing + gradient
+  float occlusion = 0.0f;   // probability a frame gets an occluder
+  unsigned seed = 1;
+  cv::Matx44d rig = cv::Matx44d::eye(); // display camera -> this camera (multi-camera runs)
+};
+
+struct SynthFrame
+{
+  cv::Mat image;            // BGR
+  cv::Vec3d rvec, tvec;     // ground truth marker -> camera (OpenCV convention)
+  bool inView{false};       // all four marker corners inside the image
+  bool occluded{false};
+  double t{0};
+};
+
+class MarkerSynth
+{
+public:
+  explicit MarkerSynth(const SynthParams &p) : p_(p), rng_(p.seed)
+  {
+    double f = 0.9 * p.width; // same dummy intrinsics as ARTracker
+    K_ = (cv::Mat_<double>(3, 3) << f, 0, p.width / 2, 0, f, p.height / 2, 0, 0, 1);
+
+    auto dict = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+    cv::Mat marker;
+    cv::aruco::generateImageMarker(dict, p.markerId, 240, marker, 1);
+    const int quiet = 240 / 8; // one cell of quiet zone
+    cv::copyMakeBorder(marker, marker_, quiet, quiet, quiet, quiet, cv::BORDER_CONSTANT, 255);
+    quietScale_ = float(marker_.cols) / 240.0f;
+
+    // Static clutter so the detector has something to reject
+    background_.create(p.height, p.width, CV_8UC3);
+    cv::RNG bgRng(p.seed * 7919u + 13u);
+    for (int y = 0; y < p.height; ++y)
+      for (int x = 0; x < p.width; ++x)
+      {
+        uchar g = uchar(90 + 60 * x / p.width + 30 * y / p.height);
+        background_.at<cv::Vec3b>(y, x) = cv::Vec3b(g, uchar(g * 0.95), uchar(g * 0.9));
+      }
+    for (int i = 0; i < 40; ++i)
+    {
+      cv::Point a(bgRng.uniform(0, p.width), bgRng.uniform(0, p.height));
+      cv::Point b = a + cv::Point(bgRng.uniform(-80, 80), bgRng.uniform(-80, 80));
+      cv::rectangle(background_, a, b, cv::Scalar::all(bgRng.uniform(0, 255)), cv::FILLED);
+    }
+  }
+
+  const cv::Mat &K() const { return K_; }
+  cv::Size size() const { return {p_.width, p_.height}; }
+  int frameCount() const { return p_.frames; }
+
+  // Ground-truth pose at time t (seconds), in the display camera
+  void pose(double t, cv::Vec3d &rvec, cv::Vec3d &tvec) const
+  {
+    double s = t * p_.speed;
+    double rx = 0.45 * std::sin(0.7 * s);       // tilt towards / away
+    double ry = 0.50 * std::sin(0.4 * s + 1.0); // tilt sideways
+    double rz = 0.30 * s;                       // in-plane spin
+    cv::Matx33d Rx(1, 0, 0, 0, std::cos(rx), -std::sin(rx), 0, std::sin(rx), std::cos(rx));
+    cv::Matx33d Ry(std::cos(ry), 0, std::sin(ry), 0, 1, 0, -std::sin(ry), 0, std::cos(ry));
+    cv::Matx33d Rz(std::cos(rz), -std::sin(rz), 0, std::sin(rz), std::cos(rz), 0, 0, 0, 1);
+    // Tilts about the 180-degree X flip: marker +Z (OpenCV) must face the camera,
+    // or the warp below would show it mirrored, as seen from behind
+    cv::Matx33d R = Rx * Ry * Rz * cv::Matx33d(1, 0, 0, 0, -1, 0, 0, 0, -1);
+    cv::Rodrigues(R, rvec);
+    tvec = cv::Vec3d(0.06 * std::sin(0.5 * s), 0.04 * std::sin(0.8 * s + 0.5),
+                     0.35 + 0.12 * std::sin(0.3 * s));
+  }
+
+  void render(int index, SynthFrame &out)
+  {
+    out.t = index / double(p_.fps);
+    pose(out.t, out.rvec, out.tvec);
+    if (p_.rig != cv::Matx44d::eye())
+    {
+      cv::Matx33d R, Rr = p_.rig.get_minor<3, 3>(0, 0);
+      cv::Rodrigues(out.rvec, R);
+      cv::Rodrigues(Rr * R, out.rvec);
+      out.tvec = Rr * out.tvec + cv::Vec3d(p_.rig(0, 3), p_.rig(1, 3), p_.rig(2, 3));
+    }
+
+    // Quiet-zone corners in marker space: TL, TR, BR, BL (ArUco order)
+    const float h = 0.5f * p_.markerLen * quietScale_;
+    std::vector<cv::Point3f> obj = {{-h, h, 0}, {h, h, 0}, {h, -h, 0}, {-h, -h, 0}};
+    std::vector<cv::Point2f> img;
+    cv::projectPoints(obj, out.rvec, out.tvec, K_, cv::noArray(), img);
+
+    // The marker proper (inside the quiet zone) decides visibility
+    const float m = 0.5f * p_.markerLen;
+    std::vector<cv::Point3f> inner = {{-m, m, 0}, {m, m, 0}, {m, -m, 0}, {-m, -m, 0}};
+    std::vector<cv::Point2f> innerImg;
+    cv::projectPoints(inner, out.rvec, out.tvec, K_, cv::noArray(), innerImg);
+    out.inView = true;
+    for (const auto &c : innerImg)
+      out.inView &= c.x >= 0 && c.y >= 0 && c.x < p_.width && c.y < p_.height;
+
+    std::vector<cv::Point2f> src = {{0, 0}, {float(marker_.cols), 0},
+                                    {float(marker_.cols), float(marker_.rows)},
+                                    {0, float(marker_.rows)}};
+    cv::Mat H = cv::getPerspectiveTransform(src, img);
+    cv::warpPerspective(marker_, warped_, H, size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, 0);
+    mask_.create(marker_.size(), CV_8U);
+    mask_.setTo(255);
+    cv::warpPerspective(mask_, warpedMask_, H, size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, 0);
+
+    background_.copyTo(out.image);
+    cv::cvtColor(warped_, warpedBgr_, cv::COLOR_GRAY2BGR);
+    warpedBgr_.copyTo(out.image, warpedMask_ > 127);
+
+    out.occluded = false;
+    if (p_.occlusion > 0 && rng_.uniform(0.0f, 1.0f) < p_.occlusion)
+    {
+      // A "hand" blob over part of the marker
+      cv::Rect box = cv::boundingRect(innerImg);
+      cv::Point c(box.x + rng_.uniform(0, std::max(1, box.width)),
+                  box.y + rng_.uniform(0, std::max(1, box.height)));
+      cv::Size axes(std::max(4, box.width / 3), std::max(4, box.height / 4));
+      cv::ellipse(out.image, c, axes, rng_.uniform(0, 180), 0, 360,
+                  cv::Scalar(120, 150, 200), cv::FILLED);
+      out.occluded = true;
+    }
+
+    if (p_.lighting > 0)
+    {
+      double gain = 1.0 + 0.5 * p_.lighting * std::sin(1.3 * out.t);
+      out.image.convertTo(out.image, -1, gain, 0);
+      lightRamp(out.image, p_.lighting);
+    }
+    if (p_.blurSigma > 0)
+      cv::GaussianBlur(out.image, out.image, cv::Size(), p_.blurSigma);
+    if (p_.noiseSigma > 0)
+    {
+      noise_.create(out.image.size(), CV_16SC3);
+      rng_.fill(noise_, cv::RNG::NORMAL, 0, p_.noiseSigma);
+      cv::add(out.image, noise_, out.image, cv::noArray(), CV_8U);
+    }
+  }
+
+private:
+  // Horizontal shading gradient (uneven lighting across the frame)
+  static void lightRamp(cv::Mat &img, float amount)
+  {
+    for (int y = 0; y < img.rows; ++y)
+    {
+      auto *row = img.ptr<cv::Vec3b>(y);
+      for (int x = 0; x < img.cols; ++x)
+      {
+        float k = 1.0f - amount * 0.6f * float(x) / img.cols;
+        row[x] = cv::Vec3b(cv::saturate_cast<uchar>(row[x][0] * k),
+                           cv::saturate_cast<uchar>(row[x][1] * k),
+                           cv::saturate_cast<uchar>(row[x][2] * k));
+      }
+    }
+  }
+
+  SynthParams p_;
+  cv::RNG rng_;
+  cv::Mat K_, marker_, background_;
+  cv::Mat warped_, warpedBgr_, mask_, warpedMask_, noise_;
+  float quietScale_{1.0f};
+};
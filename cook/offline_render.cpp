@@ -0,0 +1,432 @@
+// Batch offline renderer: re-renders a recorded session from a pose trace at
+// higher resolution / quality than live capture, using the same Scene, Object
+// and shader code as the app. Each worker thread owns a software GL context
+// (Mesa surfaceless EGL, llvmpipe) and renders whole frames independently.
+//
+// Build: make tools
+//
+// Trace format (text, '#' starts a comment):
+//   size  <w> <h>                  capture resolution
+//   K     <fx> <fy> <cx> <cy>      capture intrinsics
+//   settings <hover> <scale> <light intensity> <light warmth>
+//                                  SystemSettings, from here on
+//   frame <t> <alpha> <bg image> <m00 m01 ... m33>
+//   sim   <sim time> <n> <n x 16 floats>
+//                                  optional, the frame's body transforms
+// t is seconds since session start, alpha the marker fade (0-1) and the 16
+// floats the view matrix column-major (ARTracker::view()). Background image
+// paths are relative to the trace file. `sim` holds the body transforms the
+// app drew (scene order, column-major), so time scale, pause and inspector
+// edits replay exactly; frames without one are evaluated at t. The app
+// writes traces from the Recording panel ("Write render trace",
+// src/trace_writer.hpp).
+//
+// Usage: offline_render <trace.txt> <out_dir> [--scale 2] [--msaa 8] [--threads N] [--hw]
+// Writes out_dir/frame_NNNNNN.png plus out_dir/hashes.txt (FNV-1a of the RGBA pixels).
+
+#include <glad/glad.h>
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <glm/glm.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "ar_tracker.hpp"
+#include "assets.hpp"
+#include "bloom.hpp"
+#include "render_queue.hpp"
+#include "render_target.hpp"
+#include "shader.hpp"
+#include "shaders.hpp"
+#include "solar_system.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+struct TraceFrame
+{
+  float t{0}, alpha{1};
+  std::string bg;
+  glm::mat4 view{1.0f};
+  SystemSettings settings;
+  double simTime{0};
+  std::vector<glm::mat4> models; // empty: evaluate at t
+};
+
+struct Trace
+{
+  int w{0}, h{0};
+  double fx{0}, fy{0}, cx{0}, cy{0};
+  std::vector<TraceFrame> frames;
+};
+
+struct Options
+{
+  float scale = 2.0f;
+  int msaa = 8;
+  int threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+  bool hw = false;
+};
+
+static bool loadTrace(const std::string &path, Trace &tr)
+{
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string dir = path.substr(0, path.find_last_of('/') + 1);
+
+  std::string line;
+  SystemSettings settings;
+  while (std::getline(in, line))
+  {
+    std::istringstream ss(line);
+    std::string tag;
+    if (!(ss >> tag) || tag[0] == '#')
+      continue;
+    if (tag == "size")
+      ss >> tr.w >> tr.h;
+    else if (tag == "K")
+      ss >> tr.fx >> tr.fy >> tr.cx >> tr.cy;
+    else if (tag == "settings")
+      ss >> settings.hover >> settings.scale >> settings.lightIntensity >> settings.lightWarmth;
+    else if (tag == "sim" && !tr.frames.empty())
+    {
+      TraceFrame &f = tr.frames.back();
+      std::size_t n = 0;
+      ss >> f.simTime >> n;
+      f.models.resize(n);
+      for (glm::mat4 &m : f.models)
+        for (int i = 0; i < 16; ++i)
+          ss >> m[i / 4][i % 4];
+      if (!ss)
+      {
+        LOG_ERR("Bad trace line: %s", line.c_str());
+        return false;
+      }
+    }
+    else if (tag == "frame")
+    {
+      TraceFrame f;
+      f.settings = settings;
+      ss >> f.t >> f.alpha >> f.bg;
+      for (int i = 0; i < 16; ++i)
+        ss >> f.view[i / 4][i % 4];
+      if (!ss)
+      {
+        LOG_ERR("Bad trace line: %s", line.c_str());
+        return false;
+      }
+      f.bg = dir + f.bg;
+      tr.frames.push_back(std::move(f));
+    }
+  }
+  return tr.w > 0 && tr.h > 0 && tr.fx > 0;
+}
+
+static std::uint64_t fnv1a(const std::uint8_t *p, std::size_t n)
+{
+  std::uint64_t h = 1469598103934665603ull;
+  for (std::size_t i = 0; i < n; ++i)
+    h = (h ^ p[i]) * 1099511628211ull;
+  return h;
+}
+
+// Resolve colour attachments 0..n-1 of one FBO into the same attachments of another
+static void resolveColors(GLuint from, GLuint to, int n, int W, int H)
+{
+  static const GLenum kBufs[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, from);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, to);
+  for (int i = 0; i < n; ++i)
+  {
+    glReadBuffer(kBufs[i]);
+    glDrawBuffer(kBufs[i]);
+    glBlitFramebuffer(0, 0, W, H, 0, 0, W, H, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  }
+  glReadBuffer(kBufs[0]);
+  glDrawBuffers(n, kBufs);
+}
+
+static const EGLint kCtxAttribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 4,
+    EGL_CONTEXT_MINOR_VERSION, 1,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE};
+
+struct Shared
+{
+  const Trace &trace;
+  const Options &opt;
+  std::string outDir;
+  std::atomic<int> next{0};
+  std::atomic<int> skipped{0}; // frames without a background image
+  std::vector<std::uint64_t> hashes;
+};
+
+static void worker(EGLDisplay dpy, EGLConfig cfg, Shared &sh)
+{
+  EGLContext ctx = eglCreateContext(dpy, cfg, EGL_NO_CONTEXT, kCtxAttribs);
+  if (ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx))
+  {
+    LOG_ERR("Worker: cannot create GL context (0x%x)", eglGetError());
+    return;
+  }
+
+  const Trace &tr = sh.trace;
+  const int W = int(tr.w * sh.opt.scale), H = int(tr.h * sh.opt.scale);
+
+  // Multisampled target, resolved into a single-sample one for readback,
+  // plus a multisampled system layer (colour, emissive, depth) composited
+  // over the background exactly as the app does
+  GLuint fbo[3], rb[6];
+  glGenFramebuffers(3, fbo);
+  glGenRenderbuffers(6, rb);
+  glBindRenderbuffer(GL_RENDERBUFFER, rb[0]);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, sh.opt.msaa, GL_RGBA8, W, H);
+  glBindRenderbuffer(GL_RENDERBUFFER, rb[1]);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, sh.opt.msaa, GL_DEPTH_COMPONENT24, W, H);
+  glBindRenderbuffer(GL_RENDERBUFFER, rb[2]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, W, H);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb[1]);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo[1]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[2]);
+  for (int i = 3; i < 6; ++i)
+  {
+    glBindRenderbuffer(GL_RENDERBUFFER, rb[i]);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, sh.opt.msaa, i < 5 ? GL_RGBA8 : GL_DEPTH_COMPONENT24, W, H);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo[2]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[3]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_RENDERBUFFER, rb[4]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb[5]);
+  const GLenum layerBufs[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, layerBufs);
+  RenderTarget layer(2, false); // resolved layer, sampled by the composite
+  layer.ensure(W, H);
+  Bloom bloom;
+
+  Shader shader(VSHADER, FSHADER);
+  Shader litShader(LIT_VSHADER, LIT_FSHADER);
+  Shader bgShader(BG_VSHADER, BG_FSHADER);
+  Shader compositeShader(COMPOSITE_VSHADER, COMPOSITE_FSHADER);
+  Shader bloomDownShader(COMPOSITE_VSHADER, BLOOM_DOWN_FSHADER);
+  Shader bloomBlurShader(COMPOSITE_VSHADER, BLOOM_BLUR_FSHADER);
+  const GLuint comp = compositeShader.id();
+  glProgramUniform2f(comp, compositeShader.uniform("uUVScale"), 1.0f, 1.0f); // full resolution:
+  glProgramUniform2f(comp, compositeShader.uniform("uTexel"), 1.0f / W, 1.0f / H); // no sharpening
+  glProgramUniform1f(comp, compositeShader.uniform("uSharpness"), 0.0f);
+  glProgramUniform1i(comp, compositeShader.uniform("uBloom"), 1);
+  glProgramUniform1f(comp, compositeShader.uniform("uBloomStrength"), bloom.strength);
+  AssetRegistry assets; // per context: GL names are not shared between workers
+  MeshHandle bgQuad = assets.quad();
+  auto sys = std::make_unique<SolarSystem>(assets, 128); // finer tessellation than live
+  RenderQueue queue;
+
+  GLuint bgTex;
+  glGenTextures(1, &bgTex);
+  glBindTexture(GL_TEXTURE_2D, bgTex);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  cv::Mat K = (cv::Mat_<double>(3, 3) << tr.fx, 0, tr.cx, 0, tr.fy, tr.cy, 0, 0, 1);
+  const glm::mat4 P = makeProj(K, tr.w, tr.h, 0.01f, 100.f); // resolution independent
+
+  std::vector<std::uint8_t> pixels(std::size_t(W) * H * 4);
+  std::vector<glm::mat4> models;
+  cv::Mat bg, flipped, out;
+  char name[64];
+
+  for (int i; (i = sh.next++) < int(tr.frames.size());)
+  {
+    const TraceFrame &f = tr.frames[i];
+
+    bg = cv::imread(f.bg, cv::IMREAD_COLOR);
+    if (bg.empty())
+    {
+      LOG_ERR("Missing background %s", f.bg.c_str());
+      ++sh.skipped;
+      continue;
+    }
+    cv::cvtColor(bg, bg, cv::COLOR_BGR2RGB);
+    glBindTexture(GL_TEXTURE_2D, bgTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, bg.cols, bg.rows, 0, GL_RGB, GL_UNSIGNED_BYTE, bg.data);
+
+    if (f.models.size() != sys->scene.objects().size())
+    {
+      sys->evaluate(f.t); // older traces: no recorded transforms
+      sys->scene.snapshot(models);
+    }
+    else
+      models = f.models;
+
+    queue.setView(f.view, P);
+    const bool drawSystem = f.alpha > 0.01f;
+    if (drawSystem)
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo[2]);
+      glViewport(0, 0, W, H);
+      glClearColor(0, 0, 0, 0);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      sys->submit(queue, litShader, shader, f.view, f.settings, models);
+      queue.execute();
+      resolveColors(fbo[2], layer.fbo(), 2, W, H);
+      bloom.run(bloomDownShader, bloomBlurShader, *assets.get(bgQuad), layer.color(1), W, H, W, H);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo[0]);
+    glViewport(0, 0, W, H);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    queue.submit(RenderPass::Background, BlendMode::None, bgShader, bgTex, *assets.get(bgQuad),
+                 glm::mat4(1.0f));
+    if (drawSystem)
+    {
+      glProgramUniform1f(comp, compositeShader.uniform("uFade"), f.alpha);
+      glProgramUniform2f(comp, compositeShader.uniform("uBloomUVScale"), bloom.uvScale(0), bloom.uvScale(1));
+      glProgramUniform2f(comp, compositeShader.uniform("uBloomTexel"), bloom.texel(0), bloom.texel(1));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, bloom.texture());
+      glActiveTexture(GL_TEXTURE0);
+      queue.submit(RenderPass::Composite, BlendMode::Premultiplied, compositeShader, layer.color(),
+                   *assets.get(bgQuad), glm::mat4(1.0f));
+    }
+    queue.execute();
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[1]);
+    glBlitFramebuffer(0, 0, W, H, 0, 0, W, H, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[1]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, W, H, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    sh.hashes[i] = fnv1a(pixels.data(), pixels.size());
+
+    cv::Mat rgba(H, W, CV_8UC4, pixels.data());
+    cv::flip(rgba, flipped, 0); // GL rows are bottom-up
+    cv::cvtColor(flipped, out, cv::COLOR_RGBA2BGR);
+    std::snprintf(name, sizeof(name), "/frame_%06d.png", i);
+    cv::imwrite(sh.outDir + name, out);
+  }
+
+  sys.reset();
+  assets.shutdown();
+  glDeleteTextures(1, &bgTex);
+  bloom.destroy();
+  layer.destroy();
+  glDeleteRenderbuffers(6, rb);
+  glDeleteFramebuffers(3, fbo);
+  eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(dpy, ctx);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "usage: %s <trace.txt> <out_dir> [--scale S] [--msaa N] [--threads N] [--hw]\n", argv[0]);
+    return 1;
+  }
+
+  Options opt;
+  for (int i = 3; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--scale") && i + 1 < argc)
+      opt.scale = std::strtof(argv[++i], nullptr);
+    else if (!std::strcmp(argv[i], "--msaa") && i + 1 < argc)
+      opt.msaa = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+      opt.threads = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--hw"))
+      opt.hw = true;
+  }
+  if (!opt.hw)
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1); // llvmpipe; identical output on any machine
+
+  Trace trace;
+  if (!loadTrace(argv[1], trace))
+  {
+    LOG_ERR("Cannot read trace %s", argv[1]);
+    return 1;
+  }
+
+  auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  EGLDisplay dpy = getPlatformDisplay
+                       ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+                       : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr))
+  {
+    LOG_ERR("EGL init failed (0x%x)", eglGetError());
+    return 1;
+  }
+  eglBindAPI(EGL_OPENGL_API);
+
+  const EGLint cfgAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                               EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig cfg;
+  EGLint n = 0;
+  if (!eglChooseConfig(dpy, cfgAttribs, &cfg, 1, &n) || n == 0)
+  {
+    LOG_ERR("No suitable EGL config");
+    return 1;
+  }
+
+  // Resolve GL entry points once; they are shared by every context of this driver
+  EGLContext boot = eglCreateContext(dpy, cfg, EGL_NO_CONTEXT, kCtxAttribs);
+  eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, boot);
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+  {
+    LOG_ERR("GL 4.1 core not available");
+    return 1;
+  }
+  LOG_INF("Renderer: %s", (const char *)glGetString(GL_RENDERER));
+  eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(dpy, boot);
+
+  Shared sh{trace, opt, argv[2]};
+  sh.hashes.assign(trace.frames.size(), 0);
+
+  LOG_INF("Rendering %zu frames at %dx%d, msaa %d, %d threads", trace.frames.size(),
+          int(trace.w * opt.scale), int(trace.h * opt.scale), opt.msaa, opt.threads);
+
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (int i = 0; i < opt.threads; ++i)
+    pool.emplace_back(worker, dpy, cfg, std::ref(sh));
+  for (auto &th : pool)
+    th.join();
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  std::ofstream hashes(sh.outDir + "/hashes.txt");
+  for (std::size_t i = 0; i < sh.hashes.size(); ++i)
+  {
+    char line[48];
+    std::snprintf(line, sizeof(line), "%06zu %016llx\n", i, (unsigned long long)sh.hashes[i]);
+    hashes << line;
+  }
+
+  const std::size_t rendered = trace.frames.size() - std::size_t(sh.skipped.load());
+  std::printf("frames: %zu (%d skipped)  time: %.2fs  throughput: %.2f fps\n",
+              rendered, sh.skipped.load(), secs, rendered / secs);
+  eglTerminate(dpy);
+  return 0;
+}
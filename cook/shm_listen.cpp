@@ -0,0 +1,114 @@
+// Example consumer of the shared-memory frame ring published by ./solar.
+// Maps the ring read-only, follows the newest frame and prints rate,
+// publish-to-read latency, torn/skipped reads and the marker position.
+//
+// Build: make tools
+//
+// Usage: shm_listen [--name /solar-ar] [--seconds S] [--save frame.png]
+
+#include "shm_ring.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <time.h>
+
+static double monotonic()
+{
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+  const char *name = "/solar-ar";
+  const char *savePath = nullptr;
+  double seconds = 10.0;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--name") && i + 1 < argc)
+      name = argv[++i];
+    else if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc)
+      seconds = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--save") && i + 1 < argc)
+      savePath = argv[++i];
+  }
+
+  FrameSubscriber sub;
+  while (!sub.open(name))
+  {
+    std::fprintf(stderr, "waiting for %s...\n", name);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+  const shm::RingHeader &h = sub.header();
+  std::printf("%s: %ux%u, %u slots\n", name, h.width, h.height, h.slots);
+
+  std::uint64_t last = 0;
+  long frames = 0, torn = 0, skipped = 0;
+  double latSum = 0, latMax = 0;
+  float tx = 0, ty = 0, tz = 0;
+  bool visible = false;
+  cv::Mat saved;
+
+  const double start = monotonic();
+  double report = start + 1.0;
+  while (monotonic() - start < seconds)
+  {
+    std::uint64_t n = sub.latest();
+    if (n == last)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      continue;
+    }
+    if (last && n > last + 1)
+      skipped += long(n - last - 1);
+
+    double stamp = 0;
+    bool ok = sub.read(n, [&](const shm::SlotHeader &s, const unsigned char *px)
+                       {
+                         stamp = s.timestamp;
+                         visible = s.markerVisible != 0;
+                         tx = s.view[12], ty = s.view[13], tz = s.view[14];
+                         if (savePath && saved.empty())
+                           cv::Mat(h.height, h.width, CV_8UC3, const_cast<unsigned char *>(px), h.stride)
+                               .copyTo(saved); // only copy this example ever makes
+                       });
+    last = n;
+    if (!ok)
+    {
+      ++torn;
+      saved.release();
+      continue;
+    }
+    ++frames;
+    double lat = (monotonic() - stamp) * 1000.0;
+    latSum += lat;
+    latMax = std::max(latMax, lat);
+
+    if (monotonic() >= report)
+    {
+      std::printf("frame %llu  %ld fps  latency avg %.2f max %.2f ms  torn %ld skipped %ld  marker %s (%.3f, %.3f, %.3f)\n",
+                  (unsigned long long)n, frames, frames ? latSum / frames : 0.0, latMax, torn, skipped,
+                  visible ? "yes" : "no", tx, ty, tz);
+      frames = 0;
+      latSum = latMax = 0;
+      report += 1.0;
+    }
+  }
+
+  if (savePath && !saved.empty())
+  {
+    cv::cvtColor(saved, saved, cv::COLOR_RGB2BGR);
+    cv::imwrite(savePath, saved);
+    std::printf("saved %s\n", savePath);
+  }
+  return 0;
+}
@@ -0,0 +1,426 @@
+// Tracking accuracy / throughput benchmark on synthetic marker sequences.
+// Runs ARTracker's detect-and-pose path (ARTracker::process) without a
+// camera and compares the pose against ground truth.
+//
+// Build: make tools
+//
+// Usage: track_bench [--frames N] [--speed S] [--blur px] [--noise g] [--lighting a]
+//                    [--occlusion p] [--seed n] [--dump dir] [--detect-only]
+//                    [--fast-detect] [--compare] [--replay dir] [--multi N]
+// With no effect flags a preset suite (clean, blur, noise, lighting,
+// occlusion, fast, everything) is run. --dump writes the generated frames
+// and groundtruth.txt so sequences can be replayed elsewhere. --detect-only
+// disables optical-flow tracking so every frame runs full ArUco detection.
+// --fast-detect uses the QuadDetector candidate front end. --compare runs
+// stock ArucoDetector and QuadDetector side by side on every frame (no flow)
+// and reports speed and detection/pose parity; with --replay it reads a
+// --dump directory instead (pass the flags it was dumped with, for K).
+// --multi N adds N - 1 side cameras with their own clutter and occluders
+// and compares the display camera alone against the fused pose; with --dump
+// it writes each camera as a video plus cameras.yml, which ./solar plays
+// back in place of live cameras.
+
+#include "marker_synth.hpp"
+#include "ar_tracker.hpp"
+
+#include <glm/glm.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct Result
+{
+  std::string name;
+  int frames{0}, inView{0}, detected{0}, lost{0};
+  double fullPct{0}; // frames that ran full detection
+  double totalMs{0};
+  std::vector<double> latMs, rotErrDeg, transErrMm;
+};
+
+static double percentile(std::vector<double> v, double p)
+{
+  if (v.empty())
+    return 0.0;
+  std::size_t k = std::min(v.size() - 1, std::size_t(p * (v.size() - 1) + 0.5));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static double mean(const std::vector<double> &v)
+{
+  double s = 0;
+  for (double x : v)
+    s += x;
+  return v.empty() ? 0.0 : s / v.size();
+}
+
+// Pose error between the tracker view matrix (GL convention) and ground truth
+static void poseError(const glm::mat4 &V, const cv::Vec3d &rvec, const cv::Vec3d &tvec,
+                      double &rotDeg, double &transMm)
+{
+  // Undo the OpenCV -> OpenGL axis flip (diag(1,-1,-1) is its own inverse)
+  glm::mat4 flip(1.0f);
+  flip[1][1] = flip[2][2] = -1.0f;
+  glm::mat4 T = flip * V;
+
+  cv::Matx33d Rgt;
+  cv::Rodrigues(rvec, Rgt);
+  double tr = 0;
+  for (int i = 0; i < 3; ++i)
+    for (int k = 0; k < 3; ++k)
+      tr += double(T[i][k]) * Rgt(k, i); // trace(R_est^T * R_gt)
+  rotDeg = std::acos(std::clamp((tr - 1.0) * 0.5, -1.0, 1.0)) * 180.0 / CV_PI;
+
+  cv::Vec3d d(T[3][0] - tvec[0], T[3][1] - tvec[1], T[3][2] - tvec[2]);
+  transMm = cv::norm(d) * 1000.0;
+}
+
+// Process one frame and score it against ground truth (display camera)
+static void score(Result &r, ARTracker &tracker, const SynthFrame &f)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  bool found = tracker.process(f.image);
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+  ++r.frames;
+  r.totalMs += ms;
+  r.latMs.push_back(ms);
+  if (!f.inView)
+    return;
+  ++r.inView;
+  if (!found)
+  {
+    ++r.lost;
+    return;
+  }
+  ++r.detected;
+  double rot, trans;
+  poseError(tracker.view(), f.rvec, f.tvec, rot, trans);
+  r.rotErrDeg.push_back(rot);
+  r.transErrMm.push_back(trans);
+}
+
+static Result run(const std::string &name, const SynthParams &p, const char *dumpDir, bool flow,
+                  bool fast)
+{
+  MarkerSynth synth(p);
+  ARTracker tracker(synth.K(), synth.size(), p.markerLen);
+  tracker.track.enabled = flow;
+  tracker.track.fastDetect = fast;
+  Result r;
+  r.name = name;
+
+  std::ofstream gt;
+  if (dumpDir)
+    gt.open(std::string(dumpDir) + "/groundtruth.txt");
+
+  SynthFrame f;
+  char path[512];
+  for (int i = 0; i < synth.frameCount(); ++i)
+  {
+    synth.render(i, f);
+    if (dumpDir)
+    {
+      std::snprintf(path, sizeof(path), "%s/frame_%06d.png", dumpDir, i);
+      cv::imwrite(path, f.image);
+      gt << i << ' ' << f.t << ' ' << f.inView << ' ' << f.rvec[0] << ' ' << f.rvec[1] << ' '
+         << f.rvec[2] << ' ' << f.tvec[0] << ' ' << f.tvec[1] << ' ' << f.tvec[2] << '\n';
+    }
+
+    score(r, tracker, f);
+  }
+  const TrackStats &ts = tracker.trackStats();
+  r.fullPct = ts.frames ? 100.0 * ts.detections / ts.frames : 0.0;
+  return r;
+}
+
+// Camera k (k >= 1) in the display camera's frame: 15 cm steps to
+// alternate sides, turned towards the marker's mean position
+static cv::Matx44d sideCamera(int k)
+{
+  double x = (k % 2 ? 0.15 : -0.15) * ((k + 1) / 2);
+  double a = std::atan2(-x, 0.35), c = std::cos(a), s = std::sin(a);
+  return cv::Matx44d(c, 0, s, x,
+                     0, 1, 0, 0,
+                     -s, 0, c, 0,
+                     0, 0, 0, 1);
+}
+
+struct MultiResult
+{
+  Result single, fused;
+  std::vector<StreamStats> streams;
+  std::vector<std::string> names; // StreamStats::name dies with the tracker
+};
+
+// The display camera alone vs. fused with the side cameras. Side cameras
+// are fed in lockstep (CameraStream::process), so runs are repeatable
+static MultiResult multi(const std::string &name, const SynthParams &p, int cams, const char *dumpDir)
+{
+  std::vector<MarkerSynth> synth;
+  std::vector<cv::Matx44d> toDisplay;
+  synth.reserve(cams);
+  for (int k = 0; k < cams; ++k)
+  {
+    SynthParams q = p;
+    q.seed = p.seed + 101u * unsigned(k);
+    toDisplay.push_back(k ? sideCamera(k) : cv::Matx44d::eye());
+    q.rig = toDisplay[k].inv();
+    synth.emplace_back(q);
+  }
+  ARTracker single(synth[0].K(), synth[0].size(), p.markerLen);
+  ARTracker fused(synth[0].K(), synth[0].size(), p.markerLen);
+  for (int k = 1; k < cams; ++k)
+  {
+    CameraConfig c;
+    c.name = "side " + std::to_string(k);
+    c.source.clear(); // fed below
+    c.K = synth[k].K();
+    c.toDisplay = toDisplay[k];
+    fused.addCamera(c);
+  }
+
+  std::vector<cv::VideoWriter> video(cams);
+  if (dumpDir)
+  {
+    cv::FileStorage fs(std::string(dumpDir) + "/cameras.yml", cv::FileStorage::WRITE);
+    fs << "cameras" << "[";
+    for (int k = 0; k < cams; ++k)
+    {
+      std::string file = "cam_" + std::to_string(k) + ".avi";
+      video[k].open(std::string(dumpDir) + "/" + file, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                    p.fps, synth[k].size());
+      fs << "{" << "name" << (k ? "side " + std::to_string(k) : std::string("display"))
+         << "source" << file << "camera_matrix" << synth[k].K() << "to_display"
+         << cv::Mat(toDisplay[k]) << "}";
+    }
+    fs << "]";
+  }
+
+  MultiResult r;
+  r.single.name = name + "/1";
+  r.fused.name = name + "/" + std::to_string(cams);
+  std::vector<SynthFrame> f(cams);
+  for (int i = 0; i < p.frames; ++i)
+  {
+    for (int k = 0; k < cams; ++k)
+    {
+      synth[k].render(i, f[k]);
+      if (dumpDir)
+        video[k].write(f[k].image);
+      if (k)
+        fused.camera(k - 1).process(f[k].image);
+    }
+    score(r.single, single, f[0]);
+    score(r.fused, fused, f[0]);
+  }
+  for (ARTracker *t : {&single, &fused})
+  {
+    const TrackStats &ts = t->trackStats();
+    (t == &single ? r.single : r.fused).fullPct = ts.frames ? 100.0 * ts.detections / ts.frames : 0.0;
+  }
+  r.streams = fused.streamStats();
+  for (const StreamStats &st : r.streams)
+    r.names.push_back(st.name);
+  return r;
+}
+
+// Rotation (deg) and translation (mm) between two view matrices
+static void viewDiff(const glm::mat4 &A, const glm::mat4 &B, double &rotDeg, double &transMm)
+{
+  double tr = 0;
+  for (int i = 0; i < 3; ++i)
+    for (int k = 0; k < 3; ++k)
+      tr += double(A[i][k]) * B[i][k]; // trace(A^T B)
+  rotDeg = std::acos(std::clamp((tr - 1.0) * 0.5, -1.0, 1.0)) * 180.0 / CV_PI;
+  glm::vec3 d = glm::vec3(A[3]) - glm::vec3(B[3]);
+  transMm = std::sqrt(double(d.x * d.x + d.y * d.y + d.z * d.z)) * 1000.0;
+}
+
+struct Parity
+{
+  std::string name;
+  int frames{0}, both{0}, onlyCv{0}, onlyFast{0};
+  double cvMs{0}, fastMs{0};
+  std::vector<double> rotDeg, transMm; // fast vs. stock pose, frames both found
+};
+
+// Full detection on every frame with both front ends
+static Parity compare(const std::string &name, const SynthParams &p, const char *replayDir)
+{
+  MarkerSynth synth(p);
+  ARTracker stock(synth.K(), synth.size(), p.markerLen), fast(synth.K(), synth.size(), p.markerLen);
+  stock.track.enabled = fast.track.enabled = false;
+  fast.track.fastDetect = true;
+  Parity r;
+  r.name = name;
+
+  SynthFrame f;
+  char path[512];
+  for (int i = 0;; ++i)
+  {
+    if (replayDir)
+    {
+      std::snprintf(path, sizeof(path), "%s/frame_%06d.png", replayDir, i);
+      f.image = cv::imread(path, cv::IMREAD_COLOR);
+      if (f.image.empty())
+        break;
+    }
+    else if (i < synth.frameCount())
+      synth.render(i, f);
+    else
+      break;
+
+    auto t0 = std::chrono::steady_clock::now();
+    bool a = stock.process(f.image);
+    auto t1 = std::chrono::steady_clock::now();
+    bool b = fast.process(f.image);
+    auto t2 = std::chrono::steady_clock::now();
+    r.cvMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    r.fastMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    ++r.frames;
+
+    if (a && b)
+    {
+      ++r.both;
+      double rot, trans;
+      viewDiff(stock.view(), fast.view(), rot, trans);
+      r.rotDeg.push_back(rot);
+      r.transMm.push_back(trans);
+    }
+    else if (a)
+      ++r.onlyCv;
+    else if (b)
+      ++r.onlyFast;
+  }
+  return r;
+}
+
+static void reportParity(const Parity &r)
+{
+  int n = std::max(r.frames, 1);
+  std::printf("%-10s %5d %8.2f %8.2f %6.2fx %6d %6d %6d %7.3f %7.3f %7.2f %7.2f\n", r.name.c_str(),
+              r.frames, r.cvMs / n, r.fastMs / n, r.fastMs > 0 ? r.cvMs / r.fastMs : 0.0, r.both,
+              r.onlyCv, r.onlyFast, mean(r.rotDeg), percentile(r.rotDeg, 0.95), mean(r.transMm),
+              percentile(r.transMm, 0.95));
+}
+
+static void report(const Result &r)
+{
+  std::printf("%-10s %5d %6.1f%% %8.1f %7.2f %7.2f %7.2f %6.1f%% %7.2f %7.2f %7.1f %7.1f\n",
+              r.name.c_str(), r.frames, r.fullPct, r.frames / (r.totalMs / 1000.0),
+              mean(r.latMs), percentile(r.latMs, 0.5), percentile(r.latMs, 0.99),
+              r.inView ? 100.0 * r.lost / r.inView : 0.0,
+              mean(r.rotErrDeg), percentile(r.rotErrDeg, 0.95),
+              mean(r.transErrMm), percentile(r.transErrMm, 0.95));
+}
+
+static void reportMulti(const MultiResult &r)
+{
+  report(r.single);
+  report(r.fused);
+  for (std::size_t k = 0; k < r.streams.size(); ++k)
+  {
+    const StreamStats &s = r.streams[k];
+    std::printf("  %-8s seen %5.1f%%  fused %5.1f%%  err %.2f px\n", r.names[k].c_str(),
+                s.frames ? 100.0 * s.detections / s.frames : 0.0,
+                s.frames ? 100.0 * s.fused / s.frames : 0.0, s.reprojErr);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  SynthParams p;
+  const char *dumpDir = nullptr, *replayDir = nullptr;
+  bool custom = false, flow = true, fast = false, cmp = false;
+  int cams = 1;
+  for (int i = 1; i < argc; ++i)
+  {
+    auto val = [&]
+    { return i + 1 < argc ? std::strtof(argv[++i], nullptr) : 0.0f; };
+    if (!std::strcmp(argv[i], "--frames"))
+      p.frames = int(val());
+    else if (!std::strcmp(argv[i], "--speed"))
+      p.speed = val(), custom = true;
+    else if (!std::strcmp(argv[i], "--blur"))
+      p.blurSigma = val(), custom = true;
+    else if (!std::strcmp(argv[i], "--noise"))
+      p.noiseSigma = val(), custom = true;
+    else if (!std::strcmp(argv[i], "--lighting"))
+      p.lighting = val(), custom = true;
+    else if (!std::strcmp(argv[i], "--occlusion"))
+      p.occlusion = val(), custom = true;
+    else if (!std::strcmp(argv[i], "--seed"))
+      p.seed = unsigned(val());
+    else if (!std::strcmp(argv[i], "--dump") && i + 1 < argc)
+      dumpDir = argv[++i], custom = true;
+    else if (!std::strcmp(argv[i], "--detect-only"))
+      flow = false;
+    else if (!std::strcmp(argv[i], "--fast-detect"))
+      fast = true;
+    else if (!std::strcmp(argv[i], "--compare"))
+      cmp = true;
+    else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc)
+      replayDir = argv[++i], cmp = custom = true;
+    else if (!std::strcmp(argv[i], "--multi"))
+      cams = std::max(1, int(val()));
+  }
+
+  if (cmp)
+    std::printf("%-10s %5s %8s %8s %7s %6s %6s %6s %7s %7s %7s %7s\n", "sequence", "frm", "cv_ms",
+                "fast_ms", "speedup", "both", "cv", "fast", "d_rot", "rot95", "d_t_mm", "t95");
+  else
+    std::printf("%-10s %5s %7s %8s %7s %7s %7s %7s %7s %7s %7s %7s\n", "sequence", "frm", "full",
+                "det/s", "lat_ms", "p50", "p99", "loss", "rot_deg", "rot95", "t_mm", "t95");
+
+  if (custom)
+  {
+    if (cmp)
+      reportParity(compare(replayDir ? "replay" : "custom", p, replayDir));
+    else if (cams > 1)
+      reportMulti(multi("custom", p, cams, dumpDir));
+    else
+      report(run("custom", p, dumpDir, flow, fast));
+    return 0;
+  }
+
+  struct Preset
+  {
+    const char *name;
+    float blur, noise, lighting, occlusion, speed;
+  };
+  const Preset presets[] = {
+      {"clean", 0, 0, 0, 0, 1},
+      {"blur", 1.5f, 0, 0, 0, 1},
+      {"noise", 0, 8, 0, 0, 1},
+      {"lighting", 0, 0, 0.8f, 0, 1},
+      {"occlusion", 0, 0, 0, 0.3f, 1},
+      {"fast", 0.8f, 0, 0, 0, 3},
+      {"everything", 1.2f, 6, 0.6f, 0.2f, 2},
+  };
+  for (const Preset &pr : presets)
+  {
+    SynthParams q = p;
+    q.blurSigma = pr.blur;
+    q.noiseSigma = pr.noise;
+    q.lighting = pr.lighting;
+    q.occlusion = pr.occlusion;
+    q.speed = pr.speed;
+    if (cmp)
+      reportParity(compare(pr.name, q, nullptr));
+    else if (cams > 1)
+      reportMulti(multi(pr.name, q, cams, nullptr));
+    else
+      report(run(pr.name, q, nullptr, flow, fast));
+  }
+  return 0;
+}
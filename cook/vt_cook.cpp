@@ -0,0 +1,132 @@
+// Cooks a large equirectangular surface map into a virtual-texture tile
+// pyramid (src/vt_format.hpp) for VirtualTextures.
+// The map is resampled to a power-of-two number of kTileSize tiles per
+// side (nearest in log scale), flipped to GL row order, then each mip level
+// is cut into bordered tiles and stored as JPEG.
+//
+// Build: make tools
+//
+// Usage: vt_cook <image> <out.vt> [--quality Q] [--tiles-x N]
+//   e.g. vt_cook earth_21600x10800.tif assets/earth.vt   -> 128x64 tiles, 7 levels
+
+#include "vt_format.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static std::uint32_t pow2Tiles(int px)
+{
+  double t = std::max(1.0, double(px) / vtf::kTileSize);
+  return 1u << int(std::lround(std::log2(t)));
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "usage: %s <image> <out.vt> [--quality Q] [--tiles-x N]\n", argv[0]);
+    return 1;
+  }
+  int quality = 90;
+  std::uint32_t forceX = 0;
+  for (int i = 3; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--quality") && i + 1 < argc)
+      quality = std::clamp(std::atoi(argv[++i]), 10, 100);
+    else if (!std::strcmp(argv[i], "--tiles-x") && i + 1 < argc)
+      forceX = std::uint32_t(std::atoi(argv[++i]));
+  }
+
+  // 32k maps exceed OpenCV's default decode limit (2^30 pixels)
+  setenv("OPENCV_IO_MAX_IMAGE_PIXELS", "4294967296", 0);
+  cv::Mat img = cv::imread(argv[1], cv::IMREAD_COLOR);
+  if (img.empty())
+  {
+    std::fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  vtf::FileHeader hdr{};
+  hdr.magic = vtf::kMagic;
+  hdr.version = vtf::kVersion;
+  hdr.tilesX = forceX && !(forceX & (forceX - 1)) ? forceX : pow2Tiles(img.cols);
+  hdr.tilesY = pow2Tiles(img.rows);
+  hdr.levels = 1;
+  while ((hdr.tilesX >> hdr.levels) && (hdr.tilesY >> hdr.levels))
+    ++hdr.levels;
+  hdr.tileSize = vtf::kTileSize;
+  hdr.border = vtf::kBorder;
+  if (hdr.tilesX > 256 || hdr.tilesY > 256)
+  {
+    std::fprintf(stderr, "%ux%u tiles: page table entries hold at most 256 per side\n", hdr.tilesX,
+                 hdr.tilesY);
+    return 1;
+  }
+
+  cv::Size size(int(hdr.tilesX) * vtf::kTileSize, int(hdr.tilesY) * vtf::kTileSize);
+  std::printf("%s: %dx%d -> %dx%d, %ux%u tiles, %u levels\n", argv[1], img.cols, img.rows,
+              size.width, size.height, hdr.tilesX, hdr.tilesY, hdr.levels);
+  if (img.size() != size)
+    cv::resize(img, img, size, 0, 0, size.width < img.cols ? cv::INTER_AREA : cv::INTER_CUBIC);
+  cv::flip(img, img, 0); // bottom-up rows, as Texture uploads them
+
+  std::size_t count = 0;
+  for (std::uint32_t l = 0; l < hdr.levels; ++l)
+    count += std::size_t(vtf::tilesAt(hdr.tilesX, l)) * vtf::tilesAt(hdr.tilesY, l);
+  std::vector<vtf::TileEntry> index(count);
+
+  std::ofstream out(argv[2], std::ios::binary);
+  if (!out)
+  {
+    std::fprintf(stderr, "cannot write %s\n", argv[2]);
+    return 1;
+  }
+  out.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+  out.write(reinterpret_cast<const char *>(index.data()), std::streamsize(count * sizeof(vtf::TileEntry)));
+
+  const int B = vtf::kBorder, T = vtf::kTileSize;
+  const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, quality};
+  std::vector<unsigned char> blob;
+  cv::Mat padded, level = img;
+  std::size_t e = 0, bytes = 0;
+  for (std::uint32_t l = 0; l < hdr.levels; ++l)
+  {
+    // Border: clamp at the poles, wrap across the date line
+    cv::copyMakeBorder(level, padded, B, B, 0, 0, cv::BORDER_REPLICATE);
+    cv::copyMakeBorder(padded, padded, 0, 0, B, B, cv::BORDER_WRAP);
+
+    const std::uint32_t tx = vtf::tilesAt(hdr.tilesX, l), ty = vtf::tilesAt(hdr.tilesY, l);
+    for (std::uint32_t y = 0; y < ty; ++y)
+      for (std::uint32_t x = 0; x < tx; ++x, ++e)
+      {
+        cv::Mat tile = padded(cv::Rect(int(x) * T, int(y) * T, vtf::kPhysTile, vtf::kPhysTile));
+        cv::imencode(".jpg", tile, blob, params);
+        index[e].offset = std::uint64_t(out.tellp());
+        index[e].bytes = std::uint32_t(blob.size());
+        out.write(reinterpret_cast<const char *>(blob.data()), std::streamsize(blob.size()));
+        bytes += blob.size();
+      }
+    std::printf("  level %u: %ux%u tiles\n", l, tx, ty);
+    if (l + 1 < hdr.levels)
+      cv::resize(level, level, cv::Size(level.cols / 2, level.rows / 2), 0, 0, cv::INTER_AREA);
+  }
+
+  out.seekp(sizeof(hdr));
+  out.write(reinterpret_cast<const char *>(index.data()), std::streamsize(count * sizeof(vtf::TileEntry)));
+  if (!out)
+  {
+    std::fprintf(stderr, "write failed: %s\n", argv[2]);
+    return 1;
+  }
+  std::printf("%zu tiles, %.1f MB\n", count, bytes / (1024.0 * 1024.0));
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include "alloc_counter.hpp"
+
+#ifndef SOLAR_COUNT_ALLOCS
+#define SOLAR_COUNT_ALLOCS 0
+#endif
+
+#if SOLAR_COUNT_ALLOCS
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  // Trivially constructible: safe to touch from operator new on any thread
+  thread_local std::uint64_t tCalls = 0, tBytes = 0, tExCalls = 0, tExBytes = 0;
+  thread_local int tExempt = 0;
+
+  void count(std::size_t n)
+  {
+    if (tExempt)
+    {
+      ++tExCalls;
+      tExBytes += n;
+    }
+    else
+    {
+      ++tCalls;
+      tBytes += n;
+    }
+  }
+
+  void *counted(std::size_t n)
+  {
+    count(n);
+    return std::malloc(n ? n : 1);
+  }
+
+  void *countedAligned(std::size_t n, std::align_val_t al)
+  {
+    count(n);
+    void *p = nullptr;
+    std::size_t a = std::max(static_cast<std::size_t>(al), sizeof(void *));
+    return posix_memalign(&p, a, n ? n : 1) == 0 ? p : nullptr;
+  }
+}
+
+bool alloc::counting() { return true; }
+alloc::Counts alloc::thread() { return {tCalls, tBytes}; }
+alloc::Counts alloc::exempted() { return {tExCalls, tExBytes}; }
+alloc::Exempt::Exempt() { ++tExempt; }
+alloc::Exempt::~Exempt() { --tExempt; }
+
+void *operator new(std::size_t n)
+{
+  if (void *p = counted(n))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return operator new(n); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return counted(n); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return counted(n); }
+void *operator new(std::size_t n, std::align_val_t al)
+{
+  if (void *p = countedAligned(n, al))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t n, std::align_val_t al) { return operator new(n, al); }
+void *operator new(std::size_t n, std::align_val_t al, const std::nothrow_t &) noexcept
+{
+  return countedAligned(n, al);
+}
+void *operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t &) noexcept
+{
+  return countedAligned(n, al);
+}
+
+// posix_memalign memory is released with free() too, so every delete is the same
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+#else
+
+bool alloc::counting() { return false; }
+alloc::Counts alloc::thread() { return {}; }
+alloc::Counts alloc::exempted() { return {}; }
+alloc::Exempt::Exempt() {}
+alloc::Exempt::~Exempt() {}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocation counting for the frame loop.
+// Linked with SOLAR_COUNT_ALLOCS=1 (make ALLOC_COUNT=1; always on for the
+// bench), the global operator new/delete are replaced by versions that count
+// per thread, so a worker's allocations never show up in the render loop's
+// numbers. Otherwise counting() is false and every count reads zero.
+//
+// cv::Mat pixel data comes from cv::fastMalloc, not operator new; only its
+// header bookkeeping is seen here.
+namespace alloc
+{
+  struct Counts
+  {
+    std::uint64_t calls{0};
+    std::uint64_t bytes{0};
+  };
+
+  bool counting();
+  Counts thread();    // operator new calls made by the calling thread so far, outside Exempt
+  Counts exempted();  // ... inside Exempt scopes
+
+  // Allocations made inside this scope are counted in exempted(), not
+  // thread(): for named OpenCV calls that allocate internally and that the
+  // frame path cannot avoid (ArUco detection, LK flow, PnP). Everything
+  // around them is still held to zero. Scopes nest.
+  class Exempt
+  {
+  public:
+    Exempt();
+    ~Exempt();
+    Exempt(const Exempt &) = delete;
+    Exempt &operator=(const Exempt &) = delete;
+  };
+
+  inline Counts since(const Counts &mark)
+  {
+    Counts now = thread();
+    return {now.calls - mark.calls, now.bytes - mark.bytes};
+  }
+}
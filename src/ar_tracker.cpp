@@ -1,11 +1,17 @@
 #include <glad/glad.h>
 #include "ar_tracker.hpp"
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "alloc_counter.hpp"
 #include "logger.hpp"
 
-static glm::mat4 makeProj(const cv::Mat &K, int w, int h, float near, float far)
+glm::mat4 makeProj(const cv::Mat &K, int w, int h, float near, float far)
 {
   float fx = K.at<double>(0, 0);
   float fy = K.at<double>(1, 1);
@@ -22,25 +28,31 @@ static glm::mat4 makeProj(const cv::Mat &K, int w, int h, float near, float far)
   return P;
 }
 
-ARTracker::ARTracker(int camId, float len)
-    : markerLen_(len),
-      detector_(cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250))
+static CameraConfig cameraIndex(int camId)
 {
-  cap_.open(camId);
-  if (!cap_.isOpened()) {
-    LOG_ERR("Camera %d failed to open", camId);
+  CameraConfig c;
+  c.source = std::to_string(camId);
+  return c;
+}
+
+ARTracker::ARTracker(int camId, float len) : ARTracker(cameraIndex(camId), len) {}
+
+ARTracker::ARTracker(const CameraConfig &cfg, float len)
+    : name_(cfg.name),
+      markerLen_(len),
+      detector_(cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250)),
+      quads_(detector_.getDictionary())
+{
+  if (!cap_.open(cfg.source, cfg.realtime)) {
+    LOG_ERR("Camera %s failed to open", cfg.source.c_str());
     throw std::runtime_error("cam failed");
   }
-  
-  // ----- quick dummy intrinsics (better: load from calibration.yml)
-  int w = (int)cap_.get(cv::CAP_PROP_FRAME_WIDTH);
-  int h = (int)cap_.get(cv::CAP_PROP_FRAME_HEIGHT);
-  double f = 0.9 * w;
-  camMat_ = (cv::Mat_<double>(3, 3) << f, 0, w / 2, 0, f, h / 2, 0, 0, 1);
-  dist_ = cv::Mat::zeros(1, 5, CV_64F);
-  P_ = makeProj(camMat_, w, h, 0.01f, 100.f);  // closer near plane
-  
-  LOG_INF("Camera initialized: %dx%d, marker_len=%.3fm", w, h, markerLen_);
+
+  // Calibrated intrinsics if the config has them, else a focal length guess
+  cv::Size size = cap_.size();
+  initIntrinsics(cfg.K.empty() ? defaultIntrinsics(size) : cfg.K, cfg.dist, size);
+  LOG_INF("Camera initialized: %s %dx%d%s, marker_len=%.3fm", cfg.source.c_str(), size.width,
+          size.height, cfg.K.empty() ? " (guessed intrinsics)" : "", markerLen_);
 
   glGenTextures(1, &bgTex_);
   glBindTexture(GL_TEXTURE_2D, bgTex_);
@@ -48,32 +60,28 @@ ARTracker::ARTracker(int camId, float len)
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
-glm::mat4 ARTracker::cvToGlm(const cv::Vec3d &rvec, const cv::Vec3d &tvec)
+ARTracker::ARTracker(const cv::Mat &K, cv::Size size, float len, const cv::Mat &dist)
+    : markerLen_(len),
+      detector_(cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250)),
+      quads_(detector_.getDictionary())
 {
-  // OpenCV rotation → 3x3 matrix
-  cv::Mat Rcv;
-  cv::Rodrigues(rvec, Rcv);
-  
-  glm::mat4 T(1.0f);
-  // Copy rotation (column-major for GLM)
-  for (int r = 0; r < 3; ++r)
-    for (int c = 0; c < 3; ++c)
-      T[c][r] = static_cast<float>(Rcv.at<double>(r, c));
-  
-  // Translation
-  T[3][0] = static_cast<float>(tvec[0]);
-  T[3][1] = static_cast<float>(tvec[1]);
-  T[3][2] = static_cast<float>(tvec[2]);
-
-  // ---- Convert OpenCV(+Z) → OpenGL(-Z) coordinate system ----
-  const glm::mat4 cvToGl = glm::mat4( 1, 0, 0, 0,
-                                      0,-1, 0, 0,
-                                      0, 0,-1, 0,
-                                      0, 0, 0, 1 );
+  initIntrinsics(K, dist, size);
+}
 
-  glm::mat4 markerToCamera = cvToGl * T; // already is view matrix
+void ARTracker::initIntrinsics(const cv::Mat &K, const cv::Mat &dist, cv::Size size)
+{
+  camMat_ = K.clone();
+  dist_ = dist.empty() ? cv::Mat::zeros(1, 5, CV_64F) : dist.clone();
+  P_ = makeProj(camMat_, size.width, size.height, 0.01f, 100.f);  // closer near plane
+  solver_ = std::make_unique<PoseSolver>(camMat_, dist_, markerLen_);
+  stats_.name = name_.c_str();
+}
 
-  return markerToCamera;                 // NO glm::inverse() needed!
+glm::mat4 ARTracker::cvToGlm(const cv::Vec3d &rvec, const cv::Vec3d &tvec)
+{
+  // OpenCV(+Z) -> OpenGL(-Z) flip is folded into the conversion;
+  // marker->camera is already the view matrix, no inverse needed
+  return PoseSolver::toGlm(rvec, tvec);
 }
 
 void ARTracker::uploadBackground()
@@ -82,37 +90,370 @@ void ARTracker::uploadBackground()
     LOG_DBG("Frame empty, skipping upload");
     return;            // avoid first empty frame
   }
-  cv::cvtColor(frame_, frame_, cv::COLOR_BGR2RGB);
+  // Into a buffer of its own: in-place cvtColor clones the source every call
+  cv::cvtColor(frame_, rgb_, cv::COLOR_BGR2RGB);
   glBindTexture(GL_TEXTURE_2D, bgTex_);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, frame_.cols, frame_.rows,
-               0, GL_RGB, GL_UNSIGNED_BYTE, frame_.data);
-  LOG_DBG("Background uploaded: %dx%d", frame_.cols, frame_.rows);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (rgb_.cols != bgW_ || rgb_.rows != bgH_)
+  {
+    bgW_ = rgb_.cols;
+    bgH_ = rgb_.rows;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, bgW_, bgH_, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb_.data);
+  }
+  else // same size: update in place instead of respecifying storage
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, bgW_, bgH_, GL_RGB, GL_UNSIGNED_BYTE, rgb_.data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  LOG_DBG("Background uploaded: %dx%d", rgb_.cols, rgb_.rows);
 }
 
 bool ARTracker::grabFrame()
 {
-  if (!cap_.read(frame_) || frame_.empty()) {
+  StreamClock::time_point captured;
+  if (capRun_)
+  {
+    std::lock_guard<std::mutex> lk(capMutex_);
+    if (capSeq_ == usedSeq_)
+      return false;                           // nothing new yet
+    cv::swap(frame_, capFrame_);              // buffers rotate, no copy
+    captured = capTime_;
+    usedSeq_ = capSeq_;
+  }
+  else if (!cap_.read(frame_) || frame_.empty()) {
     LOG_ERR("Camera read failed or empty frame");
     return false;
   }
+  else
+    captured = StreamClock::now();
+
+  process(frame_, captured);
+  uploadBackground();                         // always upload feed
+  return true;
+}
+
+void ARTracker::startCapture()
+{
+  for (auto &s : streams_)
+    s->start();
+  if (capRun_ || !cap_.isOpened())
+    return;
+  capRun_ = true;
+  capThread_ = std::thread(&ARTracker::captureLoop, this);
+}
+
+void ARTracker::stopCapture()
+{
+  for (auto &s : streams_)
+    s->stop();
+  if (!capRun_)
+    return;
+  capRun_ = false;
+  capCv_.notify_all();
+  if (capThread_.joinable())
+    capThread_.join();
+}
+
+void ARTracker::setLowPower(bool on, double period)
+{
+  lowPower_ = on;
+  lowPowerPeriod_ = period;
+  for (auto &s : streams_)
+    s->setLowPower(on, period);
+}
+
+bool ARTracker::waitForFrame(double timeoutSec)
+{
+  std::unique_lock<std::mutex> lk(capMutex_);
+  return capCv_.wait_for(lk, std::chrono::duration<double>(timeoutSec),
+                         [this] { return capSeq_ != usedSeq_ || !capRun_; }) &&
+         capSeq_ != usedSeq_;
+}
+
+void ARTracker::captureLoop()
+{
+  using clock = std::chrono::steady_clock;
+  cv::Mat buf;
+  clock::time_point lastDecode{};
+  while (capRun_)
+  {
+    // grab() blocks on the driver at the camera's rate; it is cheap, the
+    // decode in retrieve() is what low power skips
+    if (!cap_.grab()) {
+      LOG_ERR("Camera grab failed");
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      continue;
+    }
+    auto now = clock::now();
+    if (lowPower_ && now - lastDecode < std::chrono::duration<double>(lowPowerPeriod_.load()))
+      continue;
+    if (!cap_.retrieve(buf) || buf.empty())
+      continue;
+    lastDecode = now;
+    {
+      std::lock_guard<std::mutex> lk(capMutex_);
+      cv::swap(buf, capFrame_);
+      capTime_ = now;
+      ++capSeq_;
+    }
+    capCv_.notify_all();
+  }
+}
+
+bool ARTracker::process(const cv::Mat &frame)
+{
+  return process(frame, StreamClock::now());
+}
+
+bool ARTracker::process(const cv::Mat &frame, StreamClock::time_point captured)
+{
+  cv::cvtColor(frame, gray_, cv::COLOR_BGR2GRAY); // detector and flow both work on grey
+  ++trackStats_.frames;
+
+  std::swap(pyr_, prevPyr_);
+  if (track.enabled && !lowPower_)
+  {
+    alloc::Exempt ex; // LK flow: OpenCV-internal temporaries
+    cv::buildOpticalFlowPyramid(gray_, pyr_, cv::Size(track.window, track.window), track.levels);
+  }
+  else
+    pyr_.clear();
+
+  bool tracked = false;
+  if (track.enabled && !lowPower_ && !ids_.empty() && !prevPyr_.empty() &&
+      sinceDetect_ + 1 < trackStats_.interval) // this frame counts: interval 1 detects every frame
+  {
+    tracked = trackFlow();
+    if (!tracked)
+    {
+      ++trackStats_.fallbacks;
+      trackStats_.interval = std::max(1, track.minInterval); // confidence dropped
+    }
+  }
+  if (!tracked)
+    detect();
 
-  std::vector<int> ids;
-  std::vector<std::vector<cv::Point2f>> corners, reject;
-  detector_.detectMarkers(frame_, corners, ids, reject);
-  
-  markerVisible_ = !ids.empty();             // remember state
-  LOG_DBG("Marker visible: %d (found %zu markers)", markerVisible_, ids.size());
+  markerVisible_ = !poses_.empty();          // remember state
+  LOG_DBG("Marker visible: %d (%zu markers, %s)", markerVisible_, ids_.size(),
+          tracked ? "tracked" : "detected");
 
   if (markerVisible_)
   {
-    std::vector<cv::Vec3d> rvecs, tvecs;
-    cv::aruco::estimatePoseSingleMarkers(corners, markerLen_, camMat_, dist_,
-                                         rvecs, tvecs);
-    V_ = cvToGlm(rvecs[0], tvecs[0]);
-    LOG_DBG("Pose: rvec=(%.2f,%.2f,%.2f) tvec=(%.2f,%.2f,%.2f)",
-            rvecs[0][0], rvecs[0][1], rvecs[0][2],
-            tvecs[0][0], tvecs[0][1], tvecs[0][2]);
+    const MarkerPose &p = poses_[0];
+    V_ = p.view;
+    LOG_DBG("Pose: rvec=(%.2f,%.2f,%.2f) tvec=(%.2f,%.2f,%.2f) err=%.2fpx%s",
+            p.rvec[0], p.rvec[1], p.rvec[2], p.tvec[0], p.tvec[1], p.tvec[2],
+            p.reprojErr, p.warmStarted ? " (warm)" : "");
   }
-  uploadBackground();                         // always upload feed
+  bool seen = markerVisible_;
+  if (!streams_.empty() && fuse.enabled)
+    markerVisible_ = fusePoses();
+  recordFrame(stats_, seen, seen ? poses_[0].reprojErr : 0.0, captured, lastFrame_);
+  return markerVisible_;
+}
+
+CameraStream &ARTracker::addCamera(const CameraConfig &cfg)
+{
+  streams_.push_back(std::make_unique<CameraStream>(cfg, markerLen_));
+  CameraStream &s = *streams_.back();
+  if (lowPower_)
+    s.setLowPower(true, lowPowerPeriod_);
+  if (capRun_)
+    s.start();
+  return s;
+}
+
+const std::vector<StreamStats> &ARTracker::streamStats()
+{
+  streamStats_.resize(streams_.size() + 1);
+  streamStats_[0] = stats_;
+  for (std::size_t k = 0; k < streams_.size(); ++k)
+    streamStats_[k + 1] = streams_[k]->stats();
+  return streamStats_;
+}
+
+bool ARTracker::fusePoses()
+{
+  // The marker this camera sees, else the first one another camera has
+  int id = poses_.empty() ? -1 : poses_[0].id;
+  for (std::size_t k = 0; id < 0 && k < streams_.size(); ++k)
+    id = streams_[k]->freshMarker(fuse.maxAgeSec);
+
+  // Every pose as marker -> display camera
+  samples_.clear();
+  const double floor2 = double(fuse.errFloorPx) * fuse.errFloorPx;
+  auto add = [&](int stream, const MarkerPose &p, const cv::Matx44d &toDisplay)
+  {
+    cv::Matx33d R;
+    cv::Rodrigues(p.rvec, R);
+    cv::Matx33d Rd = toDisplay.get_minor<3, 3>(0, 0);
+    cv::Vec3d td(toDisplay(0, 3), toDisplay(1, 3), toDisplay(2, 3));
+    samples_.push_back({stream, Rd * R, Rd * p.tvec + td,
+                        1.0 / (p.reprojErr * p.reprojErr + floor2), p.reprojErr});
+  };
+  if (!poses_.empty())
+    add(-1, poses_[0], cv::Matx44d::eye());
+  MarkerPose p;
+  for (std::size_t k = 0; id >= 0 && k < streams_.size(); ++k)
+    if (streams_[k]->latest(id, fuse.maxAgeSec, p))
+      add(int(k), p, streams_[k]->config().toDisplay);
+
+  double wsum = 0;
+  for (const FuseSample &s : samples_)
+    wsum += s.w;
+  auto share = [&](int stream)
+  {
+    for (const FuseSample &s : samples_)
+      if (s.stream == stream)
+        return float(s.w / wsum);
+    return 0.0f;
+  };
+  stats_.weight = share(-1);
+  if (stats_.weight > 0)
+    ++stats_.fused;
+  for (std::size_t k = 0; k < streams_.size(); ++k)
+    streams_[k]->noteFused(share(int(k)));
+
+  if (samples_.empty())
+    return false;
+  if (samples_.size() == 1 && samples_[0].stream < 0)
+    return true; // this camera alone: V_ is its own pose already
+
+  // Weighted mean: quaternions flipped into one hemisphere, then normalised
+  glm::dquat q0(1.0, 0.0, 0.0, 0.0), acc(0.0, 0.0, 0.0, 0.0);
+  cv::Vec3d t(0, 0, 0);
+  for (std::size_t i = 0; i < samples_.size(); ++i)
+  {
+    const FuseSample &s = samples_[i];
+    glm::dmat3 M;
+    for (int r = 0; r < 3; ++r)
+      for (int c = 0; c < 3; ++c)
+        M[c][r] = s.R(r, c);
+    glm::dquat q = glm::quat_cast(M);
+    if (i == 0)
+      q0 = q;
+    else if (glm::dot(q, q0) < 0)
+      q = -q;
+    acc += q * (s.w / wsum);
+    t += s.t * (s.w / wsum);
+  }
+  glm::dmat3 M = glm::mat3_cast(glm::normalize(acc));
+  cv::Matx33d R;
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      R(r, c) = M[c][r];
+  cv::Vec3d rvec;
+  cv::Rodrigues(R, rvec);
+  V_ = PoseSolver::toGlm(rvec, t);
+  LOG_DBG("Fused %zu poses of marker %d", samples_.size(), id);
   return true;
 }
+
+void ARTracker::detect()
+{
+  // Keep last frame's corners to measure motion against
+  prevIds_.assign(ids_.begin(), ids_.end());
+  prevPts_.clear();
+  for (const auto &c : corners_)
+    prevPts_.insert(prevPts_.end(), c.begin(), c.end());
+
+  if (lowPower_)
+  {
+    // Quarter the pixels; corners are scaled back to full resolution
+    cv::pyrDown(gray_, small_);
+    detectMarkers(small_);
+    for (auto &c : corners_)
+      for (auto &pt : c)
+        pt *= 2.0f;
+  }
+  else
+    detectMarkers(gray_);
+  solver_->solve(ids_, corners_, poses_);       // all markers, one batch
+  sinceDetect_ = 0;
+  ++trackStats_.detections;
+
+  double motion = 0;
+  int n = 0;
+  for (std::size_t k = 0; k < ids_.size(); ++k)
+  {
+    auto it = std::find(prevIds_.begin(), prevIds_.end(), ids_[k]);
+    if (it == prevIds_.end())
+      continue;
+    const cv::Point2f *prev = &prevPts_[4 * (it - prevIds_.begin())];
+    for (int c = 0; c < 4; ++c)
+      motion += cv::norm(corners_[k][c] - prev[c]);
+    n += 4;
+  }
+  if (n)
+    adaptInterval(float(motion / n));
+}
+
+void ARTracker::detectMarkers(const cv::Mat &gray)
+{
+  if (track.fastDetect)
+    quads_.detect(gray, corners_, ids_);
+  else
+  {
+    alloc::Exempt ex; // ArUco: thresholds, contours and candidates inside OpenCV
+    detector_.detectMarkers(gray, corners_, ids_, reject_);
+  }
+}
+
+bool ARTracker::trackFlow()
+{
+  prevPts_.clear();
+  for (const auto &c : corners_)
+    prevPts_.insert(prevPts_.end(), c.begin(), c.end());
+
+  // Forward then backward on the cached pyramids; a corner that does not
+  // come back to where it started is not trusted
+  const cv::Size win(track.window, track.window);
+  const cv::TermCriteria crit(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03);
+  {
+    alloc::Exempt ex;
+    cv::calcOpticalFlowPyrLK(prevPyr_, pyr_, prevPts_, nextPts_, status_, flowErr_, win,
+                             track.levels, crit);
+    cv::calcOpticalFlowPyrLK(pyr_, prevPyr_, nextPts_, backPts_, backStatus_, flowErr_, win,
+                             track.levels, crit);
+  }
+
+  const float fb2 = track.fbMaxPx * track.fbMaxPx;
+  const cv::Rect2f image(0, 0, float(gray_.cols), float(gray_.rows));
+  double motion = 0;
+  for (std::size_t i = 0; i < prevPts_.size(); ++i)
+  {
+    cv::Point2f fb = backPts_[i] - prevPts_[i];
+    if (!status_[i] || !backStatus_[i] || fb.dot(fb) > fb2 || !image.contains(nextPts_[i]))
+      return false;
+    motion += cv::norm(nextPts_[i] - prevPts_[i]);
+  }
+
+  // Into scratch first: a rejected frame must leave the corners that the
+  // fallback detection measures motion against, and the solver history
+  flowCorners_ = corners_;
+  for (std::size_t k = 0; k < flowCorners_.size(); ++k)
+    std::copy_n(&nextPts_[4 * k], 4, flowCorners_[k].begin());
+  solver_->estimate(ids_, flowCorners_, flowPoses_);
+  for (const MarkerPose &p : flowPoses_)
+    if (p.reprojErr > track.maxReprojPx) // corners drifted off a square
+      return false;
+  std::swap(corners_, flowCorners_);
+  std::swap(poses_, flowPoses_);
+  solver_->commit(poses_);
+
+  ++sinceDetect_;
+  ++trackStats_.tracked;
+  adaptInterval(float(motion / prevPts_.size()));
+  return true;
+}
+
+void ARTracker::adaptInterval(float motionPx)
+{
+  TrackStats &s = trackStats_;
+  s.motionPx = std::max(motionPx, 0.8f * s.motionPx + 0.2f * motionPx);
+
+  // Still -> maxInterval, fast -> minInterval; shrink at once, grow one frame at a time
+  float a = std::clamp((s.motionPx - track.slowPx) / std::max(track.fastPx - track.slowPx, 1e-3f),
+                       0.0f, 1.0f);
+  int target = int(std::lround(track.maxInterval - a * (track.maxInterval - track.minInterval)));
+  target = std::max(1, target);
+  s.interval = target < s.interval ? target : std::min(s.interval + 1, target);
+}
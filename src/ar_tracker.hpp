@@ -3,29 +3,164 @@
 #include <opencv2/highgui.hpp>
 #include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "camera_stream.hpp"
+#include "pose_solver.hpp"
+#include "quad_detector.hpp"
+
+// OpenCV intrinsics -> OpenGL projection (GL clip space, camera looks down -Z)
+glm::mat4 makeProj(const cv::Mat &K, int w, int h, float near, float far);
+
+// Detect-then-track: full ArUco detection runs only every `interval` frames
+// (adapted to corner motion) or when tracking loses confidence; in between,
+// the last corners are carried forward by pyramidal Lucas-Kanade flow.
+struct TrackSettings
+{
+  bool enabled = true;
+  int minInterval = 1;      // frames per full detection under fast motion
+  int maxInterval = 10;     // ... when the marker is still
+  float slowPx = 1.5f;      // mean corner motion (px/frame) treated as still
+  float fastPx = 15.0f;     // ... treated as fast
+  float fbMaxPx = 0.75f;    // forward-backward error limit per corner
+  float maxReprojPx = 2.5f; // tracked corners must still fit the marker square
+  int window = 21;          // LK window (px)
+  int levels = 3;           // LK pyramid levels above the base image
+  bool fastDetect = false;  // QuadDetector candidates instead of ArucoDetector's
+};
+
+struct TrackStats
+{
+  long frames{0}, detections{0}, tracked{0}, fallbacks{0};
+  int interval{1};     // current frames per full detection
+  float motionPx{0};   // mean corner motion per frame (fast attack, slow decay)
+};
+
+// Multi-camera fusion: every camera's pose of the display camera's marker is
+// moved into the display camera's frame (CameraConfig::toDisplay) and
+// averaged with weight 1 / (reprojErr^2 + errFloorPx^2); rotations as
+// sign-aligned quaternions
+struct FuseSettings
+{
+  bool enabled = true;
+  float maxAgeSec = 0.1f;   // older stream poses are left out
+  float errFloorPx = 0.5f;  // keeps a near-zero error from taking all the weight
+};
 
 class ARTracker
 {
 public:
   ARTracker(int camId = 0,
             float markerLength = 0.08f); // metres
-  bool grabFrame();                      // capture + detect
+  // Display camera from a config: camera index or video file, calibration
+  explicit ARTracker(const CameraConfig &cfg, float markerLength = 0.08f);
+  // Camera-less tracker for recorded / synthetic frames (no capture, no GL)
+  ARTracker(const cv::Mat &K, cv::Size size, float markerLength = 0.08f,
+            const cv::Mat &dist = cv::Mat());
+  ~ARTracker() { stopCapture(); }
+  bool grabFrame();                      // capture + detect; false if no new frame
+
+  // Background capture: the camera is read on its own thread, grabFrame()
+  // takes the newest frame without blocking and waitForFrame() sleeps
+  // until one arrives. Extra cameras are started and stopped with it.
+  void startCapture();
+  void stopCapture();
+  bool waitForFrame(double timeoutSec);  // true if a frame newer than the last grab is ready
+
+  // Low power: detection runs on a half-resolution image (no flow tracking)
+  // and the capture thread decodes at most one frame per `period` seconds
+  void setLowPower(bool on, double period = 0.1);
+  bool lowPower() const { return lowPower_; }
+  bool process(const cv::Mat &frame);    // detect + pose on a BGR frame (+ fusion)
+  bool process(const cv::Mat &frame, StreamClock::time_point captured);
   bool markerVisible() const { return markerVisible_; }
   bool hasValidFrame() const { return !frame_.empty(); }
+  const cv::Mat &frame() const { return rgb_; } // last grabbed frame, RGB (after upload)
   GLuint backgroundTex() const { return bgTex_; }
   glm::mat4 view() const { return V_; }
   glm::mat4 proj() const { return P_; }
+  const cv::Mat &intrinsics() const { return camMat_; }
+  const std::vector<MarkerPose> &poses() const { return poses_; } // all markers, this camera
+
+  // Extra cameras, each capturing and detecting on a thread of its own;
+  // process() fuses their poses into view()
+  CameraStream &addCamera(const CameraConfig &cfg);
+  std::size_t cameraCount() const { return streams_.size(); }
+  CameraStream &camera(std::size_t i) { return *streams_[i]; }
+  const std::vector<StreamStats> &streamStats(); // this camera first, then addCamera() order
+  FuseSettings fuse;
+
+  TrackSettings track;
+  const TrackStats &trackStats() const { return trackStats_; }
+  const QuadDetectorStats &quadStats() const { return quads_.stats(); }
+
+  // OpenCV marker pose (rvec, tvec) -> OpenGL view matrix
+  static glm::mat4 cvToGlm(const cv::Vec3d &rvec, const cv::Vec3d &tvec);
 
 private:
-  cv::VideoCapture cap_;
-  cv::Mat frame_;
+  FrameSource cap_;
+  std::string name_{"display"};
+  cv::Mat frame_, rgb_;              // BGR capture buffer, RGB copy for GL / publishing
   GLuint bgTex_{};
+  int bgW_{0}, bgH_{0};              // background texture storage size
   cv::Mat camMat_, dist_;
   glm::mat4 V_{1.0f}, P_{1.0f};
 
   cv::aruco::ArucoDetector detector_;
+  QuadDetector quads_;               // same dictionary; used when track.fastDetect
   float markerLen_;
+  std::unique_ptr<PoseSolver> solver_;
+  std::vector<MarkerPose> poses_;
   bool markerVisible_{false};
   void uploadBackground();
-  glm::mat4 cvToGlm(const cv::Vec3d &rvec, const cv::Vec3d &tvec);
+  void initIntrinsics(const cv::Mat &K, const cv::Mat &dist, cv::Size size);
+
+  // Multi-camera fusion
+  bool fusePoses();
+  std::vector<std::unique_ptr<CameraStream>> streams_;
+  std::vector<StreamStats> streamStats_;
+  StreamStats stats_;
+  StreamClock::time_point lastFrame_{};
+  struct FuseSample
+  {
+    int stream; // -1: this camera
+    cv::Matx33d R;
+    cv::Vec3d t;
+    double w, err;
+  };
+  std::vector<FuseSample> samples_;
+
+  // Capture thread
+  void captureLoop();
+  std::thread capThread_;
+  std::mutex capMutex_;
+  std::condition_variable capCv_;
+  cv::Mat capFrame_;                 // newest frame, swapped out by grabFrame()
+  StreamClock::time_point capTime_{}; // ... and when it was grabbed
+  std::uint64_t capSeq_{0}, usedSeq_{0};
+  std::atomic<bool> capRun_{false};
+  std::atomic<bool> lowPower_{false};
+  std::atomic<double> lowPowerPeriod_{0.1};
+  cv::Mat small_;                    // half-resolution grey for low-power detection
+
+  // Detect-then-track state, reused across frames
+  void detect();
+  void detectMarkers(const cv::Mat &gray); // candidates + decode, per track.fastDetect
+  bool trackFlow();
+  void adaptInterval(float motionPx);
+  cv::Mat gray_;
+  std::vector<cv::Mat> pyr_, prevPyr_;
+  std::vector<int> ids_, prevIds_;
+  std::vector<std::vector<cv::Point2f>> corners_, reject_, flowCorners_;
+  std::vector<MarkerPose> flowPoses_;       // trackFlow() result before it is accepted
+  std::vector<cv::Point2f> prevPts_, nextPts_, backPts_;
+  std::vector<uchar> status_, backStatus_;
+  std::vector<float> flowErr_;
+  int sinceDetect_{0};
+  TrackStats trackStats_;
 };
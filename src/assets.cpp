@@ -0,0 +1,245 @@
+#include "assets.hpp"
+#include <fstream>
+#include <iterator>
+#include "logger.hpp"
+
+namespace
+{
+  std::uint64_t fnv1a(const unsigned char *p, std::size_t n)
+  {
+    std::uint64_t h = 1469598103934665603ull;
+    for (std::size_t i = 0; i < n; ++i)
+      h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+  }
+
+  std::size_t gpuBytes(const Texture &t) { return t.bytes(); }
+  std::size_t gpuBytes(const Mesh &m) { return m.bytes; }
+}
+
+// ---- Pool ----
+
+template <class T>
+std::uint32_t AssetRegistry::Pool<T>::insert(T &&asset, const std::string &key, std::uint64_t hash)
+{
+  std::uint32_t i;
+  if (!freeList.empty())
+  {
+    i = freeList.back();
+    freeList.pop_back();
+  }
+  else
+  {
+    i = static_cast<std::uint32_t>(slots.size());
+    slots.emplace_back();
+  }
+  Slot &s = slots[i];
+  s.asset = std::move(asset);
+  s.key = key;
+  s.hash = hash;
+  s.refs = 1;
+  s.live = true;
+  byKey[key] = i;
+  if (hash)
+    byHash[hash] = i;
+  return i;
+}
+
+template <class T>
+void AssetRegistry::Pool<T>::acquire(std::uint32_t i, std::uint32_t gen)
+{
+  if (get(i, gen))
+    ++slots[i].refs;
+}
+
+template <class T>
+void AssetRegistry::Pool<T>::release(std::uint32_t i, std::uint32_t gen)
+{
+  if (!get(i, gen) || --slots[i].refs > 0)
+    return;
+  Slot &s = slots[i];
+  s.live = false;
+  ++s.gen; // outstanding handles go stale now
+  if (s.gen == 0)
+    s.gen = 1;
+  for (auto it = byKey.begin(); it != byKey.end();) // key plus any content aliases
+    it = it->second == i ? byKey.erase(it) : std::next(it);
+  if (s.hash)
+    byHash.erase(s.hash);
+  pending.push_back(i);
+}
+
+template <class T>
+void AssetRegistry::Pool<T>::collect()
+{
+  for (std::uint32_t i : pending)
+  {
+    slots[i].asset.destroy();
+    slots[i].key.clear();
+    freeList.push_back(i);
+  }
+  pending.clear();
+}
+
+template <class T>
+void AssetRegistry::Pool<T>::shutdown()
+{
+  for (std::uint32_t i = 0; i < slots.size(); ++i)
+    if (slots[i].live)
+    {
+      slots[i].refs = 1;
+      release(i, slots[i].gen);
+    }
+  collect();
+}
+
+template <class T>
+AssetStats AssetRegistry::Pool<T>::stats() const
+{
+  AssetStats st;
+  for (const Slot &s : slots)
+    if (s.live)
+    {
+      ++st.live;
+      st.bytes += gpuBytes(s.asset);
+    }
+  st.pending = pending.size();
+  st.hits = hits;
+  return st;
+}
+
+// ---- Registry ----
+
+TextureHandle AssetRegistry::loadTexture(const std::string &path)
+{
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = textures_.byKey.find(path);
+    if (it != textures_.byKey.end())
+    {
+      ++textures_.slots[it->second].refs;
+      ++textures_.hits;
+      return handle<TextureHandle>(textures_, it->second);
+    }
+  }
+
+  std::ifstream in(path, std::ios::binary);
+  std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (bytes.empty())
+  {
+    LOG_ERR("Asset not found: %s", path.c_str());
+    return {};
+  }
+  std::uint64_t hash = fnv1a(bytes.data(), bytes.size());
+
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = textures_.byHash.find(hash);
+    if (it != textures_.byHash.end())
+    {
+      ++textures_.slots[it->second].refs;
+      ++textures_.hits;
+      textures_.byKey[path] = it->second; // alias: same content, new path
+      LOG_DBG("Texture %s shares content with %s", path.c_str(),
+              textures_.slots[it->second].key.c_str());
+      return handle<TextureHandle>(textures_, it->second);
+    }
+  }
+
+  Texture tex = Texture::fromMemory(bytes.data(), static_cast<int>(bytes.size()));
+  if (!tex.id())
+    return {};
+  LOG_INF("Texture loaded: %s (%.1f MB)", path.c_str(), tex.bytes() / (1024.0 * 1024.0));
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  return handle<TextureHandle>(textures_, textures_.insert(std::move(tex), path, hash));
+}
+
+MeshHandle AssetRegistry::sphere(int seg, int ring)
+{
+  std::string key = "sphere:" + std::to_string(seg) + "x" + std::to_string(ring);
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto it = meshes_.byKey.find(key);
+  if (it != meshes_.byKey.end())
+  {
+    ++meshes_.slots[it->second].refs;
+    ++meshes_.hits;
+    return handle<MeshHandle>(meshes_, it->second);
+  }
+  return handle<MeshHandle>(meshes_, meshes_.insert(Mesh::sphere(seg, ring), key, 0));
+}
+
+MeshHandle AssetRegistry::quad()
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto it = meshes_.byKey.find("quad");
+  if (it != meshes_.byKey.end())
+  {
+    ++meshes_.slots[it->second].refs;
+    ++meshes_.hits;
+    return handle<MeshHandle>(meshes_, it->second);
+  }
+  return handle<MeshHandle>(meshes_, meshes_.insert(Mesh::quad(), "quad", 0));
+}
+
+void AssetRegistry::acquire(TextureHandle h)
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  textures_.acquire(h.index, h.gen);
+}
+
+void AssetRegistry::acquire(MeshHandle h)
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  meshes_.acquire(h.index, h.gen);
+}
+
+void AssetRegistry::release(TextureHandle h)
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  textures_.release(h.index, h.gen);
+}
+
+void AssetRegistry::release(MeshHandle h)
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  meshes_.release(h.index, h.gen);
+}
+
+const Texture *AssetRegistry::get(TextureHandle h) const
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  return textures_.get(h.index, h.gen);
+}
+
+const Mesh *AssetRegistry::get(MeshHandle h) const
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  return meshes_.get(h.index, h.gen);
+}
+
+void AssetRegistry::collect()
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  textures_.collect();
+  meshes_.collect();
+}
+
+void AssetRegistry::shutdown()
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  textures_.shutdown();
+  meshes_.shutdown();
+}
+
+AssetStats AssetRegistry::textureStats() const
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  return textures_.stats();
+}
+
+AssetStats AssetRegistry::meshStats() const
+{
+  std::lock_guard<std::mutex> lk(mtx_);
+  return meshes_.stats();
+}
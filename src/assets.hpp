@@ -0,0 +1,107 @@
+#pragma once
+#include "mesh.hpp"
+#include "texture.hpp"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Typed, generation-checked handle. A handle whose asset was freed (or whose
+// slot was reused) resolves to nullptr instead of someone else's asset.
+template <class Tag>
+struct Handle
+{
+  std::uint32_t index{0};
+  std::uint32_t gen{0}; // 0 = null handle
+  bool valid() const { return gen != 0; }
+  bool operator==(const Handle &o) const { return index == o.index && gen == o.gen; }
+  bool operator!=(const Handle &o) const { return !(*this == o); }
+};
+using MeshHandle = Handle<struct MeshTag>;
+using TextureHandle = Handle<struct TextureTag>;
+
+struct AssetStats
+{
+  std::size_t live{0};    // resident assets
+  std::size_t bytes{0};   // GPU memory estimate
+  std::size_t pending{0}; // released, waiting for collect()
+  std::size_t hits{0};    // loads served from an existing asset
+};
+
+// Ref-counted GPU asset registry.
+// Textures are deduplicated by path and by content hash (two paths holding
+// the same file share one upload); meshes by a generator key. Every load()
+// adds a reference that must be matched by release(). When the count drops
+// to zero the handle is invalidated immediately, but the GL objects are only
+// deleted by collect(), which must run on the render thread.
+//
+// Threading: loads, get() and collect() on the render thread; acquire() and
+// release() from any thread. get() takes the lock too, since release() flips
+// liveness and generations; the pointer it returns stays valid until the
+// render thread's next collect().
+class AssetRegistry
+{
+public:
+  AssetRegistry() = default;
+  AssetRegistry(const AssetRegistry &) = delete;
+  AssetRegistry &operator=(const AssetRegistry &) = delete;
+  ~AssetRegistry() = default; // no GL here; call shutdown() while the context lives
+
+  TextureHandle loadTexture(const std::string &path);
+  MeshHandle sphere(int seg = 64, int ring = 64);
+  MeshHandle quad();
+
+  void acquire(TextureHandle h);
+  void acquire(MeshHandle h);
+  void release(TextureHandle h);
+  void release(MeshHandle h);
+
+  const Texture *get(TextureHandle h) const;
+  const Mesh *get(MeshHandle h) const;
+
+  void collect();  // delete GL objects released since the last call
+  void shutdown(); // free everything regardless of references
+
+  AssetStats textureStats() const;
+  AssetStats meshStats() const;
+
+private:
+  template <class T>
+  struct Pool
+  {
+    struct Slot
+    {
+      T asset;
+      std::string key;
+      std::uint64_t hash{0};
+      std::uint32_t gen{1};
+      int refs{0};
+      bool live{false};
+    };
+    std::deque<Slot> slots; // deque: growing never moves an asset get() handed out
+    std::vector<std::uint32_t> freeList, pending;
+    std::unordered_map<std::string, std::uint32_t> byKey;
+    std::unordered_map<std::uint64_t, std::uint32_t> byHash;
+    std::size_t hits{0};
+
+    const T *get(std::uint32_t i, std::uint32_t gen) const
+    {
+      return gen && i < slots.size() && slots[i].live && slots[i].gen == gen ? &slots[i].asset : nullptr;
+    }
+    std::uint32_t insert(T &&asset, const std::string &key, std::uint64_t hash);
+    void acquire(std::uint32_t i, std::uint32_t gen);
+    void release(std::uint32_t i, std::uint32_t gen);
+    void collect();
+    void shutdown();
+    AssetStats stats() const;
+  };
+
+  template <class H, class T>
+  static H handle(const Pool<T> &p, std::uint32_t i) { return H{i, p.slots[i].gen}; }
+
+  Pool<Texture> textures_;
+  Pool<Mesh> meshes_;
+  mutable std::mutex mtx_;
+};
@@ -0,0 +1,56 @@
+#include "bloom.hpp"
+#include "shader.hpp"
+#include "mesh.hpp"
+#include <algorithm>
+
+namespace
+{
+  void setSource(const Shader &sh, GLuint tex, float uvx, float uvy, float tx, float ty)
+  {
+    sh.use();
+    glUniform1i(sh.uniform("tex"), 0);
+    glUniform2f(sh.uniform("uUVScale"), uvx, uvy);
+    glUniform2f(sh.uniform("uTexel"), tx, ty);
+    glBindTexture(GL_TEXTURE_2D, tex);
+  }
+}
+
+void Bloom::run(const Shader &down, const Shader &blur, const Mesh &quad, GLuint src,
+                int srcW, int srcH, int texW, int texH)
+{
+  w_ = std::max(1, srcW / kDownscale);
+  h_ = std::max(1, srcH / kDownscale);
+  a_.ensure(w_, h_);
+  b_.ensure(w_, h_);
+
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_BLEND);
+  glActiveTexture(GL_TEXTURE0);
+
+  // Downsample: taps one source texel off-centre, each averaging a 2x2 block
+  a_.bind(w_, h_);
+  setSource(down, src, float(srcW) / texW, float(srcH) / texH, 1.0f / texW, 1.0f / texH);
+  quad.draw();
+
+  const float u = uvScale(0), v = uvScale(1), tx = texel(0), ty = texel(1);
+
+  b_.bind(w_, h_);
+  setSource(blur, a_.color(), u, v, tx, ty);
+  glUniform2f(blur.uniform("uDir"), radius * tx, 0.0f);
+  quad.draw();
+
+  a_.bind(w_, h_);
+  setSource(blur, b_.color(), u, v, tx, ty);
+  glUniform2f(blur.uniform("uDir"), 0.0f, radius * ty);
+  quad.draw();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Bloom::destroy()
+{
+  a_.destroy();
+  b_.destroy();
+  w_ = h_ = 0;
+}
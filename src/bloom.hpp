@@ -0,0 +1,37 @@
+#pragma once
+#include "render_target.hpp"
+
+class Shader;
+struct Mesh;
+
+// Sun glow at reduced resolution, built from the system layer's emissive
+// attachment: 4-tap downsample by kDownscale, then a separable Gaussian
+// ping-ponged between two targets. The result is added in the composite.
+class Bloom
+{
+public:
+  static constexpr int kDownscale = 4;
+
+  Bloom() : a_(1, false), b_(1, false) {}
+  Bloom(const Bloom &) = delete;
+  Bloom &operator=(const Bloom &) = delete;
+
+  // src: emissive texture; (srcW, srcH) the rendered sub-rect, (texW, texH) its storage.
+  // Leaves the bloom target bound; callers rebind their own framebuffer.
+  void run(const Shader &down, const Shader &blur, const Mesh &quad, GLuint src,
+           int srcW, int srcH, int texW, int texH);
+  void destroy();
+
+  // Composite inputs (valid after run)
+  GLuint texture() const { return a_.color(); }
+  float uvScale(int axis) const { return axis ? float(h_) / a_.height() : float(w_) / a_.width(); }
+  float texel(int axis) const { return axis ? 1.0f / a_.height() : 1.0f / a_.width(); }
+
+  bool enabled = true;
+  float strength = 0.8f;
+  float radius = 1.0f; // blur step in bloom texels
+
+private:
+  RenderTarget a_, b_; // downsample/vertical result in a_, horizontal in b_
+  int w_{0}, h_{0};
+};
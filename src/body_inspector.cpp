@@ -0,0 +1,224 @@
+#include "body_inspector.hpp"
+#include "scene.hpp"
+#include "object.hpp"
+#include "simulation.hpp"
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+
+static const glm::vec3 kAxes[] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+static const char *kAxisNames[] = {"X", "Y", "Z"};
+
+static int axisIndex(const glm::vec3 &a)
+{
+  return a == kAxes[0] ? 0 : a == kAxes[1] ? 1 : 2;
+}
+
+static char lower(char c)
+{
+  return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+// ASCII case-insensitive substring match; `needle` is already lower case
+// and an empty one matches everything
+static bool contains(const std::string &hay, const char *needle, std::size_t len)
+{
+  if (!len)
+    return true;
+  auto it = std::search(hay.begin(), hay.end(), needle, needle + len,
+                        [](char a, char b) { return lower(a) == b; });
+  return it != hay.end();
+}
+
+void BodyInspector::refilter(const Scene &scene)
+{
+  char needle[sizeof(filter_)];
+  std::size_t len = 0;
+  for (; filter_[len]; ++len)
+    needle[len] = lower(filter_[len]);
+  needle[len] = 0;
+
+  // Typing usually extends the filter: every match of the new text also
+  // matched the old one, so only the rows already shown need checking
+  const auto &objs = scene.objects();
+  if (*applied_ && std::strstr(needle, applied_))
+    rows_.erase(std::remove_if(rows_.begin(), rows_.end(), [&](int b)
+                               { return !contains(objs[b]->name, needle, len); }),
+                rows_.end());
+  else
+  {
+    rows_.clear();
+    for (std::size_t i = 0; i < objs.size(); ++i)
+      if (contains(objs[i]->name, needle, len))
+        rows_.push_back(int(i));
+  }
+  std::memcpy(applied_, needle, len + 1);
+  anchorRow_ = -1;
+  filterDirty_ = false;
+}
+
+void BodyInspector::select(int row, bool ctrl, bool shift)
+{
+  int body = rows_[row];
+  if (shift && anchorRow_ >= 0)
+  {
+    if (!ctrl)
+      std::fill(selected_.begin(), selected_.end(), 0);
+    int a = std::min(anchorRow_, row), b = std::max(anchorRow_, row);
+    for (int r = a; r <= b; ++r)
+      selected_[rows_[r]] = 1;
+  }
+  else if (ctrl)
+  {
+    selected_[body] ^= 1;
+    anchorRow_ = row;
+  }
+  else
+  {
+    std::fill(selected_.begin(), selected_.end(), 0);
+    selected_[body] = 1;
+    anchorRow_ = row;
+  }
+  selCount_ = int(std::count(selected_.begin(), selected_.end(), 1));
+  selectionChanged_ = true;
+}
+
+void BodyInspector::loadBulk(const Scene &scene)
+{
+  selectionChanged_ = false;
+  auto it = std::find(selected_.begin(), selected_.end(), 1);
+  if (it == selected_.end())
+    return;
+  const Object &o = *scene.objects()[it - selected_.begin()];
+  spinDeg_ = glm::degrees(o.spinSpeed);
+  orbitDeg_ = glm::degrees(o.orbitSpeed);
+  radius_ = o.orbitRadius;
+  axis_ = axisIndex(o.orbitAxis);
+}
+
+void BodyInspector::apply(Simulation &sim)
+{
+  if (pending_.empty())
+    return;
+  selList_.clear();
+  for (std::size_t i = 0; i < selected_.size(); ++i)
+    if (selected_[i])
+      selList_.push_back(int(i));
+
+  // Only the last value of each field this frame matters
+  for (Field f : {Field::Spin, Field::OrbitSpeed, Field::OrbitRadius, Field::OrbitAxis})
+  {
+    auto it = std::find_if(pending_.rbegin(), pending_.rend(), [f](const Edit &e)
+                           { return e.field == f; });
+    if (it == pending_.rend())
+      continue;
+    SimCommand c;
+    c.op = f == Field::Spin          ? SimCommand::Op::Spin
+           : f == Field::OrbitSpeed  ? SimCommand::Op::OrbitSpeed
+           : f == Field::OrbitRadius ? SimCommand::Op::OrbitRadius
+                                     : SimCommand::Op::OrbitAxis;
+    c.value = it->value;
+    c.axis = it->axis;
+    c.bodies = selList_;
+    sim.post(std::move(c));
+  }
+  pending_.clear();
+}
+
+void BodyInspector::draw(const Scene &scene, Simulation &sim, bool *show)
+{
+  if (show && !*show)
+    return;
+
+  const auto &objs = scene.objects();
+  if (objs.size() != seenCount_)
+  {
+    selected_.assign(objs.size(), 0);
+    selCount_ = 0;
+    seenCount_ = objs.size();
+    applied_[0] = 0; // different bodies: rescan all of them
+    filterDirty_ = true;
+  }
+
+  ImGui::Begin("Bodies", show);
+
+  if (ImGui::InputTextWithHint("##filter", "filter by name", filter_, sizeof(filter_)))
+    filterDirty_ = true;
+  if (filterDirty_)
+    refilter(scene);
+  ImGui::SameLine();
+  if (ImGui::Button("Select shown"))
+  {
+    for (int b : rows_)
+      selected_[b] = 1;
+    selCount_ = int(std::count(selected_.begin(), selected_.end(), 1));
+    selectionChanged_ = true;
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Clear"))
+  {
+    std::fill(selected_.begin(), selected_.end(), 0);
+    selCount_ = 0;
+    selectionChanged_ = true;
+  }
+  ImGui::Text("%zu shown of %zu, %d selected", rows_.size(), objs.size(), selCount_);
+
+  // ---- bulk edit: one set of widgets for the whole selection ----
+  if (selCount_ > 0)
+  {
+    if (selectionChanged_)
+      loadBulk(scene);
+    ImGui::SeparatorText(selCount_ == 1 ? "Edit" : "Edit selected");
+    if (ImGui::SliderFloat("Spin (deg/s)", &spinDeg_, 0.0f, 180.0f))
+      pending_.push_back({Field::Spin, glm::radians(spinDeg_), {}});
+    if (ImGui::SliderFloat("Orbit (deg/s)", &orbitDeg_, 0.0f, 150.0f))
+      pending_.push_back({Field::OrbitSpeed, glm::radians(orbitDeg_), {}});
+    if (ImGui::SliderFloat("Orbit radius", &radius_, 0.0f, 4.0f, "%.2f", ImGuiSliderFlags_Logarithmic))
+      pending_.push_back({Field::OrbitRadius, radius_, {}});
+    if (ImGui::Combo("Orbit axis", &axis_, kAxisNames, 3))
+      pending_.push_back({Field::OrbitAxis, 0.0f, kAxes[axis_]});
+  }
+
+  // ---- body list: only visible rows are built ----
+  const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg |
+                                ImGuiTableFlags_BordersOuter | ImGuiTableFlags_Resizable;
+  if (ImGui::BeginTable("bodies", 5, flags, ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * 16)))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Name");
+    ImGui::TableSetupColumn("Spin");
+    ImGui::TableSetupColumn("Orbit");
+    ImGui::TableSetupColumn("Radius");
+    ImGui::TableSetupColumn("Parent");
+    ImGui::TableHeadersRow();
+
+    const ImGuiIO &io = ImGui::GetIO();
+    ImGuiListClipper clipper;
+    clipper.Begin(int(rows_.size()));
+    while (clipper.Step())
+      for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; ++r)
+      {
+        int b = rows_[r];
+        const Object &o = *objs[b];
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::PushID(b);
+        const char *name = o.name.empty() ? "(unnamed)" : o.name.c_str();
+        if (ImGui::Selectable(name, selected_[b] != 0, ImGuiSelectableFlags_SpanAllColumns))
+          select(r, io.KeyCtrl, io.KeyShift);
+        ImGui::PopID();
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", glm::degrees(o.spinSpeed));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", glm::degrees(o.orbitSpeed));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", o.orbitRadius);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(o.orbitTarget ? o.orbitTarget->name.c_str() : "-");
+      }
+    ImGui::EndTable();
+  }
+
+  ImGui::End();
+  apply(sim);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Scene;
+class Simulation;
+
+// Inspector for any number of Scene bodies.
+// Only the rows on screen are built (ImGuiListClipper), the name filter is
+// re-run only when its text or the body count changes (and, while the text
+// only grows, over the rows it already matched), and slider edits are
+// queued and sent once per frame, as one Simulation command per field
+// covering every selected body. Call with Simulation::lockParams() held.
+class BodyInspector
+{
+public:
+  void draw(const Scene &scene, Simulation &sim, bool *show = nullptr);
+
+private:
+  enum class Field : std::uint8_t
+  {
+    Spin,
+    OrbitSpeed,
+    OrbitRadius,
+    OrbitAxis,
+  };
+  struct Edit
+  {
+    Field field;
+    float value;     // radians/s or radius
+    glm::vec3 axis;  // OrbitAxis only
+  };
+
+  void refilter(const Scene &scene);
+  void select(int row, bool ctrl, bool shift);
+  void loadBulk(const Scene &scene); // bulk widgets <- first selected body
+  void apply(Simulation &sim);       // queued edits -> commands for the selected bodies
+
+  char filter_[64]{};
+  char applied_[64]{}; // lower-cased filter rows_ was built with
+  bool filterDirty_{true};
+  std::size_t seenCount_{0};
+  std::vector<int> rows_;               // bodies passing the filter
+  std::vector<std::uint8_t> selected_;  // per body
+  int selCount_{0};
+  int anchorRow_{-1};                   // shift-click range start
+  bool selectionChanged_{true};
+
+  // Bulk edit widget state (degrees for display)
+  float spinDeg_{0}, orbitDeg_{0}, radius_{0};
+  int axis_{1};
+  std::vector<Edit> pending_;
+  std::vector<int> selList_;
+};
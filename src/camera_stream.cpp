@@ -0,0 +1,249 @@
+#include "camera_stream.hpp"
+#include "ar_tracker.hpp"
+#include <opencv2/core/persistence.hpp>
+#include <algorithm>
+#include <cctype>
+#include "logger.hpp"
+
+cv::Mat defaultIntrinsics(cv::Size size)
+{
+  double f = 0.9 * size.width;
+  return (cv::Mat_<double>(3, 3) << f, 0, size.width / 2, 0, f, size.height / 2, 0, 0, 1);
+}
+
+static std::string resolve(const std::string &dir, const std::string &path)
+{
+  if (path.empty() || path[0] == '/' || dir.empty() ||
+      std::all_of(path.begin(), path.end(), [](unsigned char c) { return std::isdigit(c); }))
+    return path;
+  return dir + "/" + path;
+}
+
+std::vector<CameraConfig> loadCameraConfigs(const std::string &path)
+{
+  std::vector<CameraConfig> out;
+  cv::FileStorage fs;
+  try
+  {
+    if (!fs.open(path, cv::FileStorage::READ))
+      return out;
+  }
+  catch (const cv::Exception &e)
+  {
+    LOG_ERR("%s: %s", path.c_str(), e.what());
+    return out;
+  }
+
+  std::string::size_type slash = path.rfind('/');
+  std::string dir = slash == std::string::npos ? std::string() : path.substr(0, slash);
+  cv::FileNode cams = fs["cameras"];
+  for (auto it = cams.begin(); it != cams.end(); ++it)
+  {
+    cv::FileNode n = *it;
+    CameraConfig c;
+    c.name = n["name"].empty() ? "camera " + std::to_string(out.size()) : std::string(n["name"]);
+    if (!n["source"].empty())
+      c.source = resolve(dir, n["source"].isInt() ? std::to_string(int(n["source"]))
+                                                  : std::string(n["source"]));
+    n["camera_matrix"] >> c.K;
+    n["distortion_coefficients"] >> c.dist;
+    if (!n["calibration"].empty())
+    {
+      std::string calib = resolve(dir, n["calibration"]);
+      cv::FileStorage cf(calib, cv::FileStorage::READ);
+      if (cf.isOpened())
+      {
+        cf["camera_matrix"] >> c.K;
+        cf["distortion_coefficients"] >> c.dist;
+      }
+      else
+        LOG_ERR("%s: calibration %s not found, guessing intrinsics", c.name.c_str(), calib.c_str());
+    }
+    cv::Mat T;
+    n["to_display"] >> T;
+    if (T.rows == 4 && T.cols == 4)
+    {
+      T.convertTo(T, CV_64F);
+      c.toDisplay = cv::Matx44d(T.ptr<double>());
+    }
+    else if (!T.empty())
+      LOG_ERR("%s: to_display is not 4x4, using identity", c.name.c_str());
+    if (!n["realtime"].empty())
+      c.realtime = int(n["realtime"]) != 0;
+    out.push_back(std::move(c));
+  }
+  LOG_INF("%s: %zu camera(s)", path.c_str(), out.size());
+  return out;
+}
+
+bool FrameSource::open(const std::string &source, bool realtime)
+{
+  file_ = !source.empty() && !std::all_of(source.begin(), source.end(),
+                                          [](unsigned char c) { return std::isdigit(c); });
+  realtime_ = realtime;
+  if (file_)
+    cap_.open(source);
+  else
+    cap_.open(source.empty() ? 0 : std::stoi(source));
+  period_ = std::chrono::duration_cast<StreamClock::duration>(std::chrono::duration<double>(1.0 / fps()));
+  next_ = {};
+  return cap_.isOpened();
+}
+
+bool FrameSource::grab()
+{
+  if (file_ && realtime_)
+  {
+    // Frame-rate pacing; after a stall, resume from now instead of bursting
+    auto now = StreamClock::now();
+    next_ = next_ == StreamClock::time_point{} || now - next_ > period_ ? now : next_ + period_;
+    std::this_thread::sleep_until(next_);
+    if (cap_.grab())
+      return true;
+    cap_.set(cv::CAP_PROP_POS_FRAMES, 0); // end of the recording: loop
+  }
+  return cap_.grab();
+}
+
+cv::Size FrameSource::size() const
+{
+  return {int(cap_.get(cv::CAP_PROP_FRAME_WIDTH)), int(cap_.get(cv::CAP_PROP_FRAME_HEIGHT))};
+}
+
+double FrameSource::fps() const
+{
+  double f = cap_.get(cv::CAP_PROP_FPS);
+  return f > 0 && f < 1000 ? f : 30.0;
+}
+
+void recordFrame(StreamStats &s, bool seen, double reprojErr, StreamClock::time_point captured,
+                 StreamClock::time_point &lastFrame)
+{
+  auto now = StreamClock::now();
+  double ms = std::chrono::duration<double, std::milli>(now - captured).count();
+  s.latencyMs = s.frames ? 0.9 * s.latencyMs + 0.1 * ms : ms;
+  if (s.frames)
+  {
+    double dt = std::chrono::duration<double>(now - lastFrame).count();
+    if (dt > 0)
+      s.fps = s.fps > 0 ? 0.9 * s.fps + 0.1 / dt : 1.0 / dt;
+  }
+  lastFrame = now;
+  ++s.frames;
+  if (seen)
+  {
+    ++s.detections;
+    s.reprojErr = reprojErr;
+  }
+}
+
+CameraStream::CameraStream(const CameraConfig &cfg, float markerLen) : cfg_(cfg)
+{
+  cv::Size size(640, 480);
+  if (!cfg_.source.empty())
+  {
+    if (src_.open(cfg_.source, cfg_.realtime))
+      size = src_.size();
+    else
+      LOG_ERR("%s: cannot open %s", cfg_.name.c_str(), cfg_.source.c_str());
+  }
+  if (cfg_.K.empty())
+    cfg_.K = defaultIntrinsics(size);
+  tracker_ = std::make_unique<ARTracker>(cfg_.K, size, markerLen, cfg_.dist);
+  stats_.name = cfg_.name.c_str();
+  LOG_INF("Camera %s: %s, %dx%d", cfg_.name.c_str(),
+          cfg_.source.empty() ? "fed by caller" : cfg_.source.c_str(), size.width, size.height);
+}
+
+CameraStream::~CameraStream() { stop(); }
+
+void CameraStream::start()
+{
+  if (run_ || !src_.isOpened())
+    return;
+  run_ = true;
+  thread_ = std::thread(&CameraStream::loop, this);
+}
+
+void CameraStream::stop()
+{
+  run_ = false;
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void CameraStream::setLowPower(bool on, double period)
+{
+  lowPowerPeriod_ = on ? period : 0.0;
+  tracker_->setLowPower(on, period);
+}
+
+void CameraStream::loop()
+{
+  cv::Mat frame;
+  StreamClock::time_point lastDecode{};
+  while (run_)
+  {
+    if (!src_.grab())
+    {
+      LOG_ERR("%s: grab failed", cfg_.name.c_str());
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      continue;
+    }
+    auto captured = StreamClock::now();
+    double period = lowPowerPeriod_;
+    if (period > 0 && captured - lastDecode < std::chrono::duration<double>(period))
+      continue;
+    if (!src_.retrieve(frame) || frame.empty())
+      continue;
+    lastDecode = captured;
+    process(frame, captured);
+  }
+}
+
+void CameraStream::process(const cv::Mat &frame, StreamClock::time_point captured)
+{
+  // Only this thread runs tracker_; setLowPower() reaches it from the main
+  // thread, but only through its atomic low-power fields
+  bool seen = tracker_->process(frame);
+  std::lock_guard<std::mutex> lk(mutex_);
+  poses_.assign(tracker_->poses().begin(), tracker_->poses().end());
+  posesAt_ = captured;
+  recordFrame(stats_, seen, seen ? poses_[0].reprojErr : 0.0, captured, lastFrame_);
+}
+
+bool CameraStream::latest(int id, double maxAge, MarkerPose &out) const
+{
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (StreamClock::now() - posesAt_ > std::chrono::duration<double>(maxAge))
+    return false;
+  for (const MarkerPose &p : poses_)
+    if (p.id == id)
+    {
+      out = p;
+      return true;
+    }
+  return false;
+}
+
+int CameraStream::freshMarker(double maxAge) const
+{
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (poses_.empty() || StreamClock::now() - posesAt_ > std::chrono::duration<double>(maxAge))
+    return -1;
+  return poses_[0].id;
+}
+
+void CameraStream::noteFused(float weight)
+{
+  std::lock_guard<std::mutex> lk(mutex_);
+  stats_.weight = weight;
+  if (weight > 0)
+    ++stats_.fused;
+}
+
+StreamStats CameraStream::stats() const
+{
+  std::lock_guard<std::mutex> lk(mutex_);
+  return stats_;
+}
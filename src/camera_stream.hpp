@@ -0,0 +1,123 @@
+#pragma once
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pose_solver.hpp"
+
+class ARTracker;
+
+using StreamClock = std::chrono::steady_clock;
+
+// One capture source. `source` is a camera index ("0") or a video file,
+// which then stands in for a live camera; empty means frames are fed to
+// process() by the caller. K and dist come from an OpenCV calibration
+// (camera_matrix, distortion_coefficients); empty K: focal length guessed
+// as 0.9 * width, as before calibration files existed.
+struct CameraConfig
+{
+  std::string name = "display";
+  std::string source = "0";
+  cv::Mat K, dist;
+  cv::Matx44d toDisplay = cv::Matx44d::eye(); // this camera -> display camera (OpenCV axes, metres)
+  bool realtime = true;                       // files: paced at their frame rate, looping
+};
+
+// cameras.yml, camera 0 is the display camera (background, projection),
+// the rest are fused into its view:
+//   cameras:
+//     - { name: display, source: "0", calibration: "calib0.yml" }
+//     - { name: left, source: "rec/left.avi", calibration: "calib1.yml",
+//         to_display: !!opencv-matrix { rows: 4, cols: 4, dt: d, data: [...] } }
+// camera_matrix / distortion_coefficients may also be given inline.
+// Relative paths are taken from the file's directory. Empty if the file is
+// missing or unreadable.
+std::vector<CameraConfig> loadCameraConfigs(const std::string &path);
+cv::Mat defaultIntrinsics(cv::Size size);
+
+// cv::VideoCapture over a camera index or a video file. A realtime file is
+// paced at its own frame rate and restarts at the end, so grab() blocks
+// like a camera's; otherwise frames come as fast as they decode and grab()
+// fails at the end.
+class FrameSource
+{
+public:
+  bool open(const std::string &source, bool realtime = true);
+  bool isOpened() const { return cap_.isOpened(); }
+  bool isFile() const { return file_; }
+  bool grab();
+  bool retrieve(cv::Mat &frame) { return cap_.retrieve(frame); }
+  bool read(cv::Mat &frame) { return grab() && retrieve(frame); }
+  cv::Size size() const;
+  double fps() const;
+
+private:
+  cv::VideoCapture cap_;
+  bool file_{false}, realtime_{true};
+  StreamClock::duration period_{};
+  StreamClock::time_point next_{};
+};
+
+struct StreamStats
+{
+  const char *name{""};
+  long frames{0}, detections{0}; // frames processed / with a marker
+  long fused{0};                 // fused poses this camera contributed to
+  double latencyMs{0};           // capture -> pose, smoothed
+  double fps{0};                 // processed frames per second, smoothed
+  double reprojErr{0};           // last pose, px
+  float weight{0};               // share of the last fused pose, 0..1
+};
+
+// Per-frame bookkeeping shared by the display tracker and the streams
+void recordFrame(StreamStats &s, bool seen, double reprojErr, StreamClock::time_point captured,
+                 StreamClock::time_point &lastFrame);
+
+// Extra camera for ARTracker: capture, detection and pose run on a thread
+// of its own with its own calibration; the newest marker poses are kept for
+// the display tracker to fuse.
+class CameraStream
+{
+public:
+  CameraStream(const CameraConfig &cfg, float markerLen);
+  ~CameraStream();
+  CameraStream(const CameraStream &) = delete;
+  CameraStream &operator=(const CameraStream &) = delete;
+
+  void start(); // no-op without an open source
+  void stop();
+  void setLowPower(bool on, double period);
+
+  // Detect + pose on one BGR frame. The capture thread calls this; with no
+  // source, callers feed frames themselves (lockstep replay, benchmarks)
+  void process(const cv::Mat &frame, StreamClock::time_point captured);
+  void process(const cv::Mat &frame) { process(frame, StreamClock::now()); }
+
+  // Newest pose of marker `id` no older than maxAge seconds
+  bool latest(int id, double maxAge, MarkerPose &out) const;
+  int freshMarker(double maxAge) const; // any marker id with a fresh pose, -1 if none
+  void noteFused(float weight);         // display tracker, after each fusion
+
+  const CameraConfig &config() const { return cfg_; }
+  StreamStats stats() const;
+
+private:
+  void loop();
+
+  CameraConfig cfg_;
+  FrameSource src_;
+  std::unique_ptr<ARTracker> tracker_;
+  std::thread thread_;
+  std::atomic<bool> run_{false};
+  std::atomic<double> lowPowerPeriod_{0.0}; // 0: every frame
+
+  mutable std::mutex mutex_; // guards everything below
+  std::vector<MarkerPose> poses_;
+  StreamClock::time_point posesAt_{};
+  StreamStats stats_;
+  StreamClock::time_point lastFrame_{};
+};
@@ -0,0 +1,66 @@
+#include "dynamic_res.hpp"
+#include <algorithm>
+#include <cmath>
+
+void GpuTimer::begin(float tag)
+{
+  if (!q_[0])
+    glGenQueries(kLatency, q_);
+
+  // Harvest the query we are about to reuse, if the GPU is done with it
+  fresh_ = false;
+  if (issued_[head_])
+  {
+    GLint ready = 0;
+    glGetQueryObjectiv(q_[head_], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (ready)
+    {
+      GLuint64 ns = 0;
+      glGetQueryObjectui64v(q_[head_], GL_QUERY_RESULT, &ns);
+      ms_ = static_cast<float>(ns / 1.0e6);
+      tag_ = tags_[head_];
+      fresh_ = true;
+    }
+  }
+  tags_[head_] = tag;
+  glBeginQuery(GL_TIME_ELAPSED, q_[head_]);
+}
+
+void GpuTimer::end()
+{
+  glEndQuery(GL_TIME_ELAPSED);
+  issued_[head_] = true;
+  head_ = (head_ + 1) % kLatency;
+}
+
+void GpuTimer::destroy()
+{
+  if (q_[0])
+    glDeleteQueries(kLatency, q_);
+  for (int i = 0; i < kLatency; ++i)
+  {
+    q_[i] = 0;
+    issued_[i] = false;
+  }
+  fresh_ = false;
+}
+
+void DynamicResolution::update(float gpuMs, float renderedScale)
+{
+  if (!enabled)
+  {
+    scale = std::clamp(scale, minScale, maxScale);
+    return;
+  }
+  if (gpuMs <= 0.0f || renderedScale <= 0.0f)
+    return;
+
+  // Cost scales with pixel count (scale^2): aim straight at the budget from
+  // the scale that frame was drawn at (results lag a few frames), then move
+  // a fraction of the way there to avoid oscillation
+  float ideal = renderedScale * std::sqrt(targetMs / gpuMs);
+  float next = scale + 0.2f * (ideal - scale);
+  if (std::fabs(next - scale) > 0.01f)
+    scale = next;
+  scale = std::clamp(scale, minScale, maxScale);
+}
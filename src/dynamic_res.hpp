@@ -0,0 +1,40 @@
+#pragma once
+#include <glad/glad.h>
+
+// GPU time of a section of the frame via GL_TIME_ELAPSED queries.
+// Results are read kLatency frames later and only when available, so
+// measuring never stalls the pipeline. The tag passed to begin() travels
+// with its query, so a late result can be matched to the state it measured.
+class GpuTimer
+{
+public:
+  void begin(float tag = 0.0f);
+  void end();
+  float ms() const { return ms_; }          // most recent completed measurement
+  float tag() const { return tag_; }        // begin() tag of that measurement
+  bool harvested() const { return fresh_; } // the last begin() read a new result
+  void destroy();
+
+private:
+  static constexpr int kLatency = 4;
+  GLuint q_[kLatency]{};
+  bool issued_[kLatency]{};
+  float tags_[kLatency]{};
+  int head_{0};
+  float ms_{0.0f}, tag_{0.0f};
+  bool fresh_{false};
+};
+
+// Picks the 3D layer's render scale from measured GPU time
+struct DynamicResolution
+{
+  bool enabled = true;
+  float minScale = 0.5f;
+  float maxScale = 1.0f;
+  float targetMs = 8.0f;  // GPU budget for the 3D layer
+  float sharpness = 0.4f; // upscale sharpening (0 = plain bilinear)
+  float scale = 1.0f;     // current
+
+  // One fresh measurement: gpuMs of a frame rendered at renderedScale
+  void update(float gpuMs, float renderedScale);
+};
@@ -0,0 +1,108 @@
+#include "frame_publisher.hpp"
+#include "logger.hpp"
+#include <new>
+#include <time.h>
+
+bool FramePublisher::open(const char *name, int width, int height)
+{
+  close();
+
+  const std::uint32_t stride = std::uint32_t(width) * 3;
+  const std::size_t pixelOffset = shm::align(sizeof(shm::SlotHeader));
+  const std::size_t slotBytes = shm::align(pixelOffset + std::size_t(stride) * height);
+  const std::size_t total = shm::totalBytes(slots_, slotBytes);
+
+  ::shm_unlink(name); // stale ring from a crashed run
+  int fd = ::shm_open(name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+  {
+    LOG_ERR("shm_open(%s) failed", name);
+    return false;
+  }
+  if (::ftruncate(fd, total) != 0)
+  {
+    LOG_ERR("ftruncate(%s, %zu) failed", name, total);
+    ::close(fd);
+    ::shm_unlink(name);
+    return false;
+  }
+  void *p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+  {
+    LOG_ERR("mmap(%s) failed", name);
+    ::shm_unlink(name);
+    return false;
+  }
+  base_ = static_cast<unsigned char *>(p);
+  size_ = total;
+  name_ = name;
+  frame_ = 0;
+
+  // ftruncate zero-fills: every slot starts at seq 0 (even, frame 0 = empty)
+  auto *h = new (base_) shm::RingHeader{};
+  h->slots = slots_;
+  h->width = width;
+  h->height = height;
+  h->stride = stride;
+  h->format = shm::RGB8;
+  h->slotBytes = slotBytes;
+  h->pixelOffset = pixelOffset;
+  h->latest.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < slots_; ++i)
+    new (base_ + shm::headerBytes() + i * slotBytes) shm::SlotHeader{};
+  h->version = shm::kVersion;
+  std::atomic_thread_fence(std::memory_order_release);
+  h->magic = shm::kMagic; // last: subscribers check it
+
+  LOG_INF("Publishing frames to shm %s (%d slots, %.1f MB)", name, slots_, total / 1048576.0);
+  return true;
+}
+
+void FramePublisher::close()
+{
+  if (!base_)
+    return;
+  ::munmap(base_, size_);
+  ::shm_unlink(name_.c_str()); // open subscribers keep their mapping
+  base_ = nullptr;
+  size_ = 0;
+}
+
+void FramePublisher::publish(const cv::Mat &rgb, const glm::mat4 &view, const glm::mat4 &proj,
+                             bool markerVisible)
+{
+  if (!base_)
+    return;
+  auto &h = *reinterpret_cast<shm::RingHeader *>(base_);
+  if (rgb.type() != CV_8UC3 || rgb.cols != int(h.width) || rgb.rows != int(h.height))
+    return;
+
+  const std::uint64_t n = ++frame_;
+  unsigned char *slot = base_ + shm::headerBytes() + ((n - 1) % h.slots) * h.slotBytes;
+  auto &sh = *reinterpret_cast<shm::SlotHeader *>(slot);
+
+  // Seqlock write: odd while the slot is inconsistent
+  std::uint64_t s = sh.seq.load(std::memory_order_relaxed);
+  sh.seq.store(s + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  sh.frame = n;
+  sh.timestamp = ts.tv_sec + 1e-9 * ts.tv_nsec;
+  std::memcpy(sh.view, &view[0][0], sizeof(sh.view));
+  std::memcpy(sh.proj, &proj[0][0], sizeof(sh.proj));
+  sh.markerVisible = markerVisible;
+
+  unsigned char *dst = slot + h.pixelOffset;
+  const std::size_t row = h.stride;
+  if (rgb.isContinuous())
+    std::memcpy(dst, rgb.data, row * h.height);
+  else
+    for (int y = 0; y < rgb.rows; ++y)
+      std::memcpy(dst + y * row, rgb.ptr(y), row);
+
+  sh.seq.store(s + 2, std::memory_order_release);
+  h.latest.store(n, std::memory_order_release);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "shm_ring.hpp"
+#include <opencv2/core.hpp>
+#include <glm/glm.hpp>
+#include <string>
+
+// Writes every camera frame plus the tracked pose into a shared-memory
+// ring (layout in shm_ring.hpp) for other processes on this machine.
+// The frame is copied once, straight into its slot; the writer never
+// waits for readers.
+class FramePublisher
+{
+public:
+  explicit FramePublisher(int slots = 4) : slots_(slots) {}
+  ~FramePublisher() { close(); }
+  FramePublisher(const FramePublisher &) = delete;
+  FramePublisher &operator=(const FramePublisher &) = delete;
+
+  bool open(const char *name, int width, int height); // creates / replaces the shm object
+  void close();                                       // unmaps and unlinks
+  bool isOpen() const { return base_ != nullptr; }
+
+  // rgb: CV_8UC3 of the size given to open()
+  void publish(const cv::Mat &rgb, const glm::mat4 &view, const glm::mat4 &proj, bool markerVisible);
+
+  std::uint64_t published() const { return frame_; }
+  std::size_t bytes() const { return size_; }
+  const std::string &name() const { return name_; }
+
+private:
+  int slots_;
+  std::string name_;
+  unsigned char *base_{nullptr};
+  std::size_t size_{0};
+  std::uint64_t frame_{0};
+};
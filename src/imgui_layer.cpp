@@ -25,6 +25,13 @@ void ui::ImGuiLayer::end()
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+bool ui::ImGuiLayer::inputActive() const
+{
+  const ImGuiIO &io = ImGui::GetIO();
+  return io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f || io.MouseWheel != 0.0f ||
+         ImGui::IsAnyMouseDown() || ImGui::IsAnyItemActive() || io.InputQueueCharacters.Size > 0;
+}
+
 void ui::ImGuiLayer::shutdown()
 {
   ImGui_ImplOpenGL3_Shutdown();
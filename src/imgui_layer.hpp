@@ -10,6 +10,7 @@ namespace ui
     void init(GLFWwindow *win); // call once after OpenGL is ready
     void begin();               // call every frame BEFORE you render 3-D
     void end();                 // call every frame AFTER you render 3-D
+    bool inputActive() const;   // mouse/keyboard activity this frame (after begin)
     void shutdown();            // call once on exit
   };
 
@@ -5,116 +5,42 @@
 #include <algorithm>
 
 #include "shader.hpp"
-#include "mesh.hpp"
-#include "texture.hpp"
+#include "assets.hpp"
 #include "object.hpp"
 #include "scene.hpp"
+#include "solar_system.hpp"
+#include "stereo.hpp"
+#include "render_target.hpp"
+#include "dynamic_res.hpp"
+#include "trails.hpp"
+#include "bloom.hpp"
+#include "virtual_texture.hpp"
+#include "frame_publisher.hpp"
+#include "simulation.hpp"
 #include "ar_tracker.hpp"
+#include "render_queue.hpp"
+#include "alloc_counter.hpp"
+#include "recorder.hpp"
+#include "trace_writer.hpp"
+#include "shaders.hpp"
 #include "logger.hpp"
 
 #include "imgui_layer.hpp"
 #include "ui_panel.hpp"
+#include "body_inspector.hpp"
 
 #include <iostream>
+#include <sys/resource.h>
 
-static const char *VSHADER = R"(
-#version 410 core
-layout(location=0) in vec3 aPos;
-layout(location=1) in vec2 aUV;
-uniform mat4 MVP;
-out vec2 vUV;
-void main(){ vUV=aUV; gl_Position=MVP*vec4(aPos,1.0); }
-)";
-
-static const char *FSHADER = R"(
-#version 410 core
-in vec2 vUV; 
-uniform sampler2D tex; 
-uniform float uAlpha;
-out vec4 FragColor;
-void main(){ 
-  FragColor = texture(tex, vUV);
-  FragColor.a *= uAlpha;
-}
-)";
-
-// Lit shaders for planets (with lighting)
-static const char *LIT_VSHADER = R"(
-#version 410 core
-layout(location=0) in vec3 aPos;
-layout(location=1) in vec2 aUV;
-layout(location=2) in vec3 aNrm;
-
-uniform mat4 MVP;
-uniform mat4 MV;
-uniform mat3 NormalM;
-
-out vec2 vUV;
-out vec3 vNormal;
-out vec3 vViewPos;
-
-void main() {
-    vUV = aUV;
-    vNormal = NormalM * aNrm;
-    vViewPos = vec3(MV * vec4(aPos, 1.0));
-    gl_Position = MVP * vec4(aPos, 1.0);
-}
-)";
-
-static const char *LIT_FSHADER = R"(
-#version 410 core
-in vec2 vUV;
-in vec3 vNormal;
-in vec3 vViewPos;
-
-uniform sampler2D tex;
-uniform vec3 lightPosVS;
-uniform vec3 lightColor;
-uniform float uAlpha;
-
-out vec4 FragColor;
-
-void main() {
-    vec3 N = normalize(-vNormal);  // Flip normal to point outward
-    vec3 L = normalize(lightPosVS - vViewPos);
-    vec3 V = normalize(-vViewPos);
-    vec3 R = reflect(-L, N);
-    
-    // Lighting calculations
-    float diff = max(dot(N, L), 0.0);
-    float spec = pow(max(dot(R, V), 0.0), 32.0);
-    
-    // Add hemisphere lighting for better fill (simulates sky light)
-    vec3 skyDir = vec3(0, 1, 0); // up direction in view space
-    float hemisphere = 0.25 * max(dot(N, skyDir), 0.0);
-    
-    vec3 albedo = texture(tex, vUV).rgb;
-    vec3 ambient = 0.15 * albedo;
-    vec3 diffuse = diff * albedo * lightColor;
-    vec3 specular = spec * 0.3 * lightColor;
-    vec3 fill = hemisphere * albedo * lightColor * 0.4; // subtle fill light
-    
-    vec3 color = ambient + diffuse + specular + fill;
-    FragColor = vec4(color, uAlpha);
+// Process CPU time (user + system), for utilisation in the status log
+static double cpuSeconds()
+{
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + 1e-6 * (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
 }
-)";
-
-// Background shaders (for AR camera feed)
-static const char *BG_VSHADER = R"(
-#version 410 core
-layout(location=0) in vec2 aPos;
-layout(location=1) in vec2 aUV;
-out vec2 vUV;
-void main(){ vUV=aUV; gl_Position=vec4(aPos,0.0,1.0); }
-)";
-
-static const char *BG_FSHADER = R"(
-#version 410 core
-in vec2 vUV; uniform sampler2D tex; out vec4 FragColor;
-void main(){ FragColor = texture(tex, vUV); }
-)";
-
-int main()
+
+int main(int argc, char **argv)
 {
   LOG_INF("Starting AR Solar System");
 
@@ -133,53 +59,26 @@ int main()
   Shader shader(VSHADER, FSHADER);        // unlit shader for Sun
   Shader litShader(LIT_VSHADER, LIT_FSHADER); // lit shader for planets
   Shader bgShader(BG_VSHADER, BG_FSHADER);
-  Mesh sphere = Mesh::sphere();
-
-  // Create background quad for AR camera feed (correct vertex order for TRIANGLE_STRIP)
-  GLuint bgVAO, bgVBO;
-  float quad[] = {
-      // pos.xy   uv
-      -1.f, -1.f, 0.f, 1.f, // lower-left
-      1.f, -1.f, 1.f, 1.f,  // lower-right
-      -1.f, 1.f, 0.f, 0.f,  // upper-left
-      1.f, 1.f, 1.f, 0.f    // upper-right
-  };
-  glGenVertexArrays(1, &bgVAO);
-  glBindVertexArray(bgVAO);
-  glGenBuffers(1, &bgVBO);
-  glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-  // Visible solar system scales (all in marker units)
-  Object sun{sphere, Texture("assets/sun.jpg")};
-  sun.localScale = glm::vec3(0.18f);  // Use localScale field
-  sun.spinSpeed = glm::radians(15.f);  // 3x faster: 5°/s → 15°/s
-
-  Object earth{sphere, Texture("assets/earth.jpg")};
-  earth.localScale = glm::vec3(0.08f);  // Use localScale field
-  earth.spinSpeed = glm::radians(90.f);  // 3x faster: 30°/s → 90°/s
-  earth.orbitRadius = 0.4f;              
-  earth.orbitSpeed = glm::radians(24.f);  // 3x faster: 8°/s → 24°/s
-  earth.orbitAxis = glm::normalize(glm::vec3(0.1f, 0, 1)); 
-
-  Object moon{sphere, Texture("assets/moon.jpg")};
-  moon.localScale = glm::vec3(0.02f);  // Use localScale field
-  moon.spinSpeed = glm::radians(60.f);  // 3x faster: 20°/s → 60°/s               
-  moon.orbitRadius = 0.12f;  // Increased distance from Earth (was 0.08f - too close!)                                   
-  moon.orbitSpeed = glm::radians(75.f);  // 3x faster: 25°/s → 75°/s              
-  moon.orbitTarget = &earth;                                  
-  moon.orbitAxis = glm::normalize(glm::vec3(0.1f, 0, 1));
-
-  LOG_INF("Solar system created - Sun:%.3f Earth:%.3f Moon:%.3f", 0.18f, 0.08f, 0.02f);
-
-  Scene scene;
-  scene.add(&sun); // put them back so scene.update() moves them
-  scene.add(&earth);
-  scene.add(&moon);
+  Shader stereoShader(STEREO_VSHADER, FSHADER);  // single-pass stereo variants
+  Shader stereoLitShader(STEREO_LIT_VSHADER, LIT_FSHADER);
+  Shader stereoBgShader(STEREO_BG_VSHADER, BG_FSHADER);
+  Shader compositeShader(COMPOSITE_VSHADER, COMPOSITE_FSHADER); // upscale + sharpen 3-D layer
+  Shader trailShader(TRAIL_VSHADER, TRAIL_FSHADER);
+  Shader bloomDownShader(COMPOSITE_VSHADER, BLOOM_DOWN_FSHADER);
+  Shader bloomBlurShader(COMPOSITE_VSHADER, BLOOM_BLUR_FSHADER);
+  Shader litVTShader(LIT_VSHADER, LIT_VT_FSHADER); // virtually textured planets
+  Shader stereoLitVTShader(STEREO_LIT_VSHADER, LIT_VT_FSHADER);
+  Shader vtFeedbackShader(LIT_VSHADER, VT_FEEDBACK_FSHADER);
+  AssetRegistry assets;
+  MeshHandle bgQuad = assets.quad(); // background quad for AR camera feed
+
+  SolarSystem sys(assets);
+  Simulation sim(sys.scene); // fixed-rate thread; the render loop only reads snapshots
+
+  VirtualTextures vtex; // streamed surfaces, if assets/*.vt have been cooked
+  sys.useVirtualTextures(vtex);
+  for (const Shader *sh : {&litVTShader, &stereoLitVTShader})
+    glProgramUniform1i(sh->id(), sh->uniform("uVTCache"), VirtualTextures::kCacheUnit);
 
   glEnable(GL_DEPTH_TEST);
   double last = glfwGetTime();
@@ -187,35 +86,107 @@ int main()
   ui::ImGuiLayer gui;
   gui.init(win);
 
-  ARTracker ar;
+  // cameras.yml (or the file given): display camera + extra cameras to fuse;
+  // without one, camera 0 with guessed intrinsics
+  std::vector<CameraConfig> cams = loadCameraConfigs(argc > 1 ? argv[1] : "cameras.yml");
+  ARTracker ar(cams.empty() ? CameraConfig{} : cams[0]);
+  for (std::size_t i = 1; i < cams.size(); ++i)
+    ar.addCamera(cams[i]);
+  RenderQueue queue;
+  FrameRecorder recorder;
+  TraceWriter trace;               // session trace for cook/offline_render
   bool showUI = true;
   static float alpha = 0.0f;   // for smooth fade in/out
-  static float gHover = 0.06f; // hover height above marker (closer to tablet for demo)
-  static float gSystemScale = 0.3f; // smaller system by default for demo
-  static float gLightIntensity = 0.8f; // sun light intensity (reduced from 1.0 for realism)
-  static float gLightWarmth = 0.95f; // light warmth (yellow vs white)
+  static SystemSettings gSettings; // hover, scale and lighting (ImGui panel)
+  static StereoRig gStereo;        // side-by-side output (ImGui panel)
+  BodyInspector inspector;          // per-body orbit/spin editing
+  static DynamicResolution gDynRes; // 3-D layer render scale (ImGui panel)
+  RenderTarget layer(2);           // offscreen 3-D layer: colour + Sun emissive
+  Bloom bloom;                     // quarter-resolution glow from the emissive attachment
+  GpuTimer layerTimer;
+  Trails trails;                   // orbit trails, one ring buffer for all bodies
+  FramePublisher publisher;        // frames + pose to shared memory for local consumers
+  static bool gPublish = true;
 
   // FPS logging
   static double fpsTimer = 0;
   static int frames = 0;
+  double cpuLast = cpuSeconds();
+
+  // Render-thread heap allocations (make ALLOC_COUNT=1); zero once warmed up
+  alloc::Counts allocMark = alloc::thread(), allocWindow;
+  long long allocsPerFrame = alloc::counting() ? 0 : -1;
 
+  // Idle: no marker, nothing fading, no input for a while -> wake at kIdleHz
+  // on a timeout or an input event instead of every camera frame
+  constexpr double kIdleHz = 10.0;
+  constexpr double kInputHoldSec = 3.0;
+  bool idle = false;
+  double lastInput = glfwGetTime();
+
+  ar.startCapture();
+  sim.start();
   LOG_INF("Entering main loop");
 
   while (!glfwWindowShouldClose(win))
   {
+    // Block, never spin: active frames are paced by the camera, idle ones by the timeout
+    if (idle)
+      glfwWaitEventsTimeout(1.0 / kIdleHz);
+    else
+    {
+      ar.waitForFrame(0.1);
+      glfwPollEvents();
+    }
+
     double now = glfwGetTime();
     float dt = static_cast<float>(now - last);
     last = now;
+    alloc::Counts a = alloc::since(allocMark); // previous iteration, whole
+    allocMark = alloc::thread();
+    allocWindow.calls += a.calls;
+    allocWindow.bytes += a.bytes;
 
-    ar.grabFrame(); // updates V, P + bg texture
+    bool fresh = ar.grabFrame(); // newest frame if any: updates V, P + bg texture
+    if (fresh && gPublish)
+    {
+      const cv::Mat &f = ar.frame();
+      if (!publisher.isOpen() && !publisher.open("/solar-ar", f.cols, f.rows))
+        gPublish = false;
+      else
+        publisher.publish(f, ar.view(), ar.proj(), ar.markerVisible());
+    }
+    else if (!gPublish && publisher.isOpen())
+      publisher.close();
 
     // FPS and status logging
     fpsTimer += dt;
     ++frames;
     if (fpsTimer > 2.0)
     { // every 2 seconds
-      LOG_INF("FPS: %d  alpha: %.2f  marker: %s  frame: %s",
-              frames / 2, alpha, ar.markerVisible() ? "yes" : "no", ar.hasValidFrame() ? "valid" : "empty");
+      const RenderStats &rs = queue.stats();
+      double cpuNow = cpuSeconds();
+      LOG_INF("FPS: %.0f  CPU: %.0f%%%s  alpha: %.2f  marker: %s  frame: %s  draws: %d prog: %d tex: %d vao: %d",
+              frames / fpsTimer, 100.0 * (cpuNow - cpuLast) / fpsTimer, idle ? " (idle)" : "", alpha,
+              ar.markerVisible() ? "yes" : "no", ar.hasValidFrame() ? "valid" : "empty",
+              rs.draws, rs.programBinds, rs.textureBinds, rs.vaoBinds);
+      cpuLast = cpuNow;
+      const TrackStats &ts = ar.trackStats();
+      LOG_INF("TRACK detect: %ld  flow: %ld  fallback: %ld  interval: %d  motion: %.1fpx",
+              ts.detections, ts.tracked, ts.fallbacks, ts.interval, ts.motionPx);
+      if (recorder.recording())
+      {
+        RecorderStats st = recorder.stats();
+        LOG_INF("REC queue: %d/%d  encoded: %llu  dropped: %llu", st.queueDepth, st.queueCapacity,
+                (unsigned long long)st.encoded, (unsigned long long)st.dropped);
+      }
+      if (alloc::counting())
+      {
+        allocsPerFrame = (long long)(allocWindow.calls / frames);
+        LOG_INF("ALLOC %.1f/frame  %.1f KB/frame", double(allocWindow.calls) / frames,
+                allocWindow.bytes / 1024.0 / frames);
+        allocWindow = {};
+      }
       fpsTimer = 0;
       frames = 0;
     }
@@ -224,7 +195,6 @@ int main()
     if (!ar.hasValidFrame())
     {
       LOG_DBG("No valid frame yet, continuing...");
-      glfwPollEvents();
       continue;
     }
 
@@ -233,7 +203,14 @@ int main()
                                : std::max(alpha - dt * 4.0f, 0.0f);
 
     gui.begin();
-    drawOrbitalPanel(sun, earth, moon, gHover, gSystemScale, gLightIntensity, gLightWarmth, &showUI);
+    if (gui.inputActive())
+      lastInput = now;
+    drawOrbitalPanel(sim, gSettings.hover, gSettings.scale, gSettings.lightIntensity,
+                     gSettings.lightWarmth, &showUI);
+    {
+      auto params = sim.lockParams();
+      inspector.draw(sys.scene, sim, &showUI);
+    }
 
     // Debug feedback when no marker detected
     if (!ar.markerVisible())
@@ -247,18 +224,32 @@ int main()
 
     int w, h;
     glfwGetFramebufferSize(win, &w, &h);
-    glViewport(0, 0, w, h);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    // ---- draw background quad (always) ----
-    bgShader.use();
-    glBindTexture(GL_TEXTURE_2D, ar.backgroundTex());
-    glBindVertexArray(bgVAO);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE); // ensure quad draws regardless of winding
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glEnable(GL_CULL_FACE); // re-enable for 3D objects
-    glEnable(GL_DEPTH_TEST);
+    drawRenderStats(queue.stats(), assets, allocsPerFrame, &showUI);
+    drawRecorderPanel(recorder, trace, w, h, ar.intrinsics(), ar.frame().size(), &showUI);
+    drawStereoPanel(gStereo, &showUI);
+    drawTrackingPanel(ar.track, ar.trackStats(), ar.quadStats(), &showUI);
+    drawCameraPanel(ar.fuse, ar.streamStats(), &showUI);
+    drawResolutionPanel(gDynRes, layerTimer.ms(), w, h, &showUI);
+    drawTrailsPanel(trails, &showUI);
+    drawBloomPanel(bloom, &showUI);
+    if (vtex.active())
+      drawVirtualTexturePanel(vtex, &showUI);
+    drawPublisherPanel(publisher, gPublish, &showUI);
+
+    queue.beginFrame();
+    queue.setView(ar.view(), ar.proj());
+    glm::mat4 eyeProj[2];
+    if (gStereo.enabled)
+    {
+      gStereo.eyeProjections(ar.proj(), eyeProj);
+      queue.setStereo(eyeProj);
+    }
+    else
+      queue.setMono();
+    const Shader &bgSh = gStereo.enabled ? stereoBgShader : bgShader;
+    const Shader &unlitSh = gStereo.enabled ? stereoShader : shader;
+    const Shader &litSh = gStereo.enabled ? stereoLitShader : litShader;
+    const Shader *litVTSh = !vtex.active() ? nullptr : gStereo.enabled ? &stereoLitVTShader : &litVTShader;
 
     static bool loggedBg = false;
     if (!loggedBg && ar.hasValidFrame())
@@ -267,39 +258,40 @@ int main()
       loggedBg = true;
     }
 
-    // ---- update & draw solar system (only when marker visible and alpha > 0) ----
-    if (ar.markerVisible() && alpha > 0.01f)
+    // ---- 3-D layer: solar system, opaque, into the offscreen target at the dynamic scale ----
+    const bool drawSystem = ar.markerVisible() && alpha > 0.01f;
+    const std::vector<glm::mat4> *drawnModels = nullptr; // for the trace
+    int lw = std::max(1, static_cast<int>(w * gDynRes.scale));
+    int lh = std::max(1, static_cast<int>(h * gDynRes.scale));
+    if (drawSystem)
     {
+      const std::vector<glm::mat4> &models = sim.sample(); // interpolated to this frame
+      drawnModels = &models;
+      const glm::mat4 &sunM = models[SolarSystem::Sun], &earthM = models[SolarSystem::Earth];
+
       // Debug: Check if sun is in front of camera
       static int debugCounter = 0;
       if (++debugCounter % 60 == 0)
       { // every 2 seconds at 30fps
         glm::vec4 sunViewPos = ar.view() * glm::vec4(0, 0, 0, 1);
-        glm::vec4 earthViewPos = ar.view() * earth.model * glm::vec4(0, 0, 0, 1);
-        glm::vec4 offsetPos = gHover * glm::vec4(0, 0, 0, 1); // origin after offset
+        glm::vec4 earthViewPos = ar.view() * earthM * glm::vec4(0, 0, 0, 1);
+        glm::vec4 offsetPos = gSettings.hover * glm::vec4(0, 0, 0, 1); // origin after offset
         LOG_INF("Sun in view space: (%.3f, %.3f, %.3f)", sunViewPos.x, sunViewPos.y, sunViewPos.z);
         LOG_INF("Earth in view space: (%.3f, %.3f, %.3f)", earthViewPos.x, earthViewPos.y, earthViewPos.z);
         LOG_INF("Hover offset: (%.2f, %.2f, %.2f) - Z should be +%.2f",
-                offsetPos.x, offsetPos.y, offsetPos.z, gHover);
+                offsetPos.x, offsetPos.y, offsetPos.z, gSettings.hover);
       }
 
-      scene.update(dt, static_cast<float>(now));
-
-      // Move entire system above marker along its +Z axis (away from tablet surface)
-      glm::mat4 hover = glm::translate(glm::mat4(1.0f),
-                                       glm::vec3(0, 0, +gHover)); // POSITIVE = above tablet
-      glm::mat4 scaling = glm::scale(glm::mat4(1.0f), glm::vec3(gSystemScale)); // global scale
-      glm::mat4 transform = hover * scaling;
-      glm::mat4 VP = ar.proj() * ar.view() * transform;
+      glm::mat4 transform = gSettings.transform();
 
       // Calculate Sun's actual center position in view space for lighting
-      glm::vec3 sunPosVS = glm::vec3(ar.view() * transform * sun.model * glm::vec4(0, 0, 0, 1));
+      glm::vec3 sunPosVS = glm::vec3(ar.view() * transform * sunM * glm::vec4(0, 0, 0, 1));
 
       // Debug: Log lighting positions occasionally
       static int lightDebugCounter = 0;
       if (++lightDebugCounter % 120 == 0) { // every 4 seconds at 30fps
-        glm::vec3 earthPosWorld = glm::vec3(transform * earth.model * glm::vec4(0, 0, 0, 1));
-        glm::vec3 sunPosWorld = glm::vec3(transform * sun.model * glm::vec4(0, 0, 0, 1));
+        glm::vec3 earthPosWorld = glm::vec3(transform * earthM * glm::vec4(0, 0, 0, 1));
+        glm::vec3 sunPosWorld = glm::vec3(transform * sunM * glm::vec4(0, 0, 0, 1));
         glm::vec3 earthPosVS = glm::vec3(ar.view() * glm::vec4(earthPosWorld, 1));
         
         LOG_INF("LIGHTING DEBUG:");
@@ -312,40 +304,114 @@ int main()
         LOG_INF("  Light direction to Earth: (%.2f, %.2f, %.2f)", lightDir.x, lightDir.y, lightDir.z);
       }
 
-      // Enable alpha blending for fade effect
-      glEnable(GL_BLEND);
-      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-      // 1) Draw planets with lighting
-      litShader.use();
-      glUniform1f(glGetUniformLocation(litShader.id(), "uAlpha"), alpha);
-      glUniform3fv(glGetUniformLocation(litShader.id(), "lightPosVS"), 1, &sunPosVS[0]);
-      glUniform3f(glGetUniformLocation(litShader.id(), "lightColor"), 
-                  1.0f * gLightIntensity, gLightWarmth * gLightIntensity, 0.8f * gLightIntensity); // warm sunlight
-      
-      earth.draw(litShader, VP, ar.view(), transform);
-      moon.draw(litShader, VP, ar.view(), transform);
-
-      // 2) Draw Sun last with unlit shader (emissive)
-      glDepthMask(GL_FALSE);
-      shader.use();
-      glUniform1f(glGetUniformLocation(shader.id(), "uAlpha"), alpha);
-      sun.draw(shader, VP);
-      glDepthMask(GL_TRUE);
-
-      glDisable(GL_BLEND);
-      LOG_DBG("Drew solar system with alpha %.2f", alpha);
+      vtex.update(); // uploads decoded tiles, so before the layer samples the cache
+
+      layer.ensure(w, h);
+      layer.bind(lw, lh);
+      glClearColor(0, 0, 0, 0); // transparent: composited over the camera image
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      layerTimer.begin(gDynRes.scale);
+      sys.submit(queue, litSh, unlitSh, ar.view(), gSettings, models, litVTSh);
+      if (litVTSh)
+        vtex.bindCache();
+      queue.execute();
+      if (trails.enabled)
+      {
+        trails.record(models, sim.orbiting());
+        glm::mat4 VT = ar.view() * gSettings.transform();
+        if (gStereo.enabled)
+          for (int eye = 0; eye < 2; ++eye)
+            trails.draw(trailShader, eyeProj[eye] * VT, eye);
+        else
+          trails.draw(trailShader, ar.proj() * VT);
+      }
+      else
+        trails.clear(); // no gap when switched back on
+      if (bloom.enabled)
+        bloom.run(bloomDownShader, bloomBlurShader, *assets.get(bgQuad), layer.color(1), lw, lh,
+                  layer.width(), layer.height());
+      layerTimer.end();
+      if (layerTimer.harvested())
+        gDynRes.update(layerTimer.ms(), layerTimer.tag());
+
+      // Which virtual texture tiles this view needs; read back frames later
+      if (vtex.active())
+      {
+        vtex.beginFeedback(vtFeedbackShader, lw, lh);
+        queue.setMono(); // one eye is enough to pick tiles
+        sys.submitFeedback(queue, vtFeedbackShader, gSettings, models);
+        queue.execute();
+        vtex.endFeedback();
+        if (gStereo.enabled)
+          queue.setStereo(eyeProj);
+      }
+      LOG_DBG("Drew solar system at %dx%d (scale %.2f) with alpha %.2f", lw, lh, gDynRes.scale, alpha);
     }
 
+    // ---- screen: camera background + upscaled layer, faded once ----
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, w, h);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    queue.submit(RenderPass::Background, BlendMode::None, bgSh, ar.backgroundTex(),
+                 *assets.get(bgQuad), glm::mat4(1.0f));
+    if (drawSystem)
+    {
+      GLuint comp = compositeShader.id();
+      glProgramUniform2f(comp, compositeShader.uniform("uUVScale"),
+                         float(lw) / layer.width(), float(lh) / layer.height());
+      glProgramUniform2f(comp, compositeShader.uniform("uTexel"),
+                         1.0f / layer.width(), 1.0f / layer.height());
+      glProgramUniform1f(comp, compositeShader.uniform("uSharpness"),
+                         gDynRes.scale < 1.0f ? gDynRes.sharpness : 0.0f);
+      glProgramUniform1f(comp, compositeShader.uniform("uFade"), alpha);
+      glProgramUniform1i(comp, compositeShader.uniform("uBloom"), 1);
+      glProgramUniform2f(comp, compositeShader.uniform("uBloomUVScale"), bloom.uvScale(0), bloom.uvScale(1));
+      glProgramUniform2f(comp, compositeShader.uniform("uBloomTexel"), bloom.texel(0), bloom.texel(1));
+      glProgramUniform1f(comp, compositeShader.uniform("uBloomStrength"),
+                         bloom.enabled ? bloom.strength : 0.0f);
+      glActiveTexture(GL_TEXTURE1); // the queue only binds unit 0
+      glBindTexture(GL_TEXTURE_2D, bloom.enabled ? bloom.texture() : 0);
+      glActiveTexture(GL_TEXTURE0);
+      queue.submit(RenderPass::Composite, BlendMode::Premultiplied, compositeShader, layer.color(),
+                   *assets.get(bgQuad), glm::mat4(1.0f));
+    }
+    queue.execute();
+    assets.collect(); // GL deletes for anything released this frame
+    if (trace.recording())
+      trace.record(now, drawSystem ? alpha : 0.0f, fresh ? ar.frame() : cv::Mat(), ar.view(),
+                   sim.stats().simTime, drawnModels, gSettings);
+
     gui.end();
+    recorder.capture(w, h); // composited frame incl. UI; async PBO readback
     glfwSwapBuffers(win);
-    glfwPollEvents();
 
     if (glfwGetKey(win, GLFW_KEY_TAB) == GLFW_PRESS)
       showUI = !showUI;
+
+    // Decide next frame's pacing; the marker coming back ends idle on the frame it is seen
+    bool wasIdle = idle;
+    idle = !ar.markerVisible() && alpha <= 0.0f && !recorder.recording() &&
+           now - lastInput > kInputHoldSec;
+    if (idle != wasIdle)
+    {
+      ar.setLowPower(idle, 1.0 / kIdleHz);
+      LOG_INF("%s", idle ? "Idle: low-rate, half-resolution detection" : "Active: full rate");
+    }
   }
 
   LOG_INF("Shutting down");
+  ar.stopCapture();
+  sim.stop();
+  publisher.close();
+  recorder.stop();
+  trace.stop();
+  layer.destroy();
+  bloom.destroy();
+  vtex.destroy();
+  layerTimer.destroy();
+  trails.destroy();
+  assets.shutdown(); // while the context is still current
   gui.shutdown();
   glfwTerminate();
   return 0;
@@ -6,6 +6,17 @@ Mesh Mesh::sphere(int seg, int ring)
 {
   std::vector<float> verts;
   std::vector<unsigned> idx;
+  sphereGeometry(seg, ring, verts, idx);
+  return upload(verts, idx);
+}
+
+void Mesh::sphereGeometry(int seg, int ring, std::vector<float> &verts,
+                          std::vector<unsigned> &idx)
+{
+  verts.clear();
+  idx.clear();
+  verts.reserve(std::size_t(ring + 1) * (seg + 1) * 8);
+  idx.reserve(std::size_t(ring) * seg * 6);
 
   for (int y = 0; y <= ring; ++y)
   {
@@ -33,9 +44,27 @@ Mesh Mesh::sphere(int seg, int ring)
       unsigned b = a + seg + 1;
       idx.insert(idx.end(), {a, b, a + 1, b, b + 1, a + 1});
     }
+}
 
+Mesh Mesh::quad()
+{
+  // Same UV convention as the camera background: v flipped so row 0 is on top
+  std::vector<float> verts = {
+      // pos           uv          normal
+      -1.f, -1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, // lower-left
+      1.f, -1.f, 0.f, 1.f, 1.f, 0.f, 0.f, 1.f,  // lower-right
+      -1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f,  // upper-left
+      1.f, 1.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f    // upper-right
+  };
+  std::vector<unsigned> idx = {0, 1, 2, 1, 3, 2};
+  return upload(verts, idx);
+}
+
+Mesh Mesh::upload(const std::vector<float> &verts, const std::vector<unsigned> &idx)
+{
   Mesh m;
   m.indexCount = static_cast<GLsizei>(idx.size());
+  m.bytes = verts.size() * sizeof(float) + idx.size() * sizeof(unsigned);
 
   glGenVertexArrays(1, &m.vao);
   glBindVertexArray(m.vao);
@@ -58,3 +87,32 @@ Mesh Mesh::sphere(int seg, int ring)
 
   return m;
 }
+
+Mesh &Mesh::operator=(Mesh &&o) noexcept
+{
+  if (this != &o)
+  {
+    vao = o.vao;
+    vbo = o.vbo;
+    ebo = o.ebo;
+    indexCount = o.indexCount;
+    bytes = o.bytes;
+    o.vao = o.vbo = o.ebo = 0;
+    o.indexCount = 0;
+    o.bytes = 0;
+  }
+  return *this;
+}
+
+void Mesh::destroy()
+{
+  if (vao)
+    glDeleteVertexArrays(1, &vao);
+  if (vbo)
+    glDeleteBuffers(1, &vbo);
+  if (ebo)
+    glDeleteBuffers(1, &ebo);
+  vao = vbo = ebo = 0;
+  indexCount = 0;
+  bytes = 0;
+}
@@ -2,22 +2,34 @@
 #include <glad/glad.h>
 #include <vector>
 
+// Owns a VAO + VBO/EBO. Move-only; GL objects are freed explicitly with
+// destroy() (AssetRegistry defers that to the render thread).
 struct Mesh
 {
   GLuint vao{}, vbo{}, ebo{};
   GLsizei indexCount{0};
+  std::size_t bytes{0}; // vertex + index buffer size
 
   // Constructors
   Mesh() = default;
-  Mesh(const Mesh&) = default;
-  Mesh& operator=(const Mesh&) = default;
-  Mesh(Mesh&&) = default;
-  Mesh& operator=(Mesh&&) = default;
+  Mesh(const Mesh&) = delete;
+  Mesh& operator=(const Mesh&) = delete;
+  Mesh(Mesh &&o) noexcept { *this = static_cast<Mesh &&>(o); }
+  Mesh& operator=(Mesh &&o) noexcept;
 
   static Mesh sphere(int seg = 64, int ring = 64);
+  // CPU side of sphere(): interleaved position/uv/normal + triangle indices
+  static void sphereGeometry(int seg, int ring, std::vector<float> &verts,
+                             std::vector<unsigned> &idx);
+  static Mesh quad(); // full-screen quad in NDC (background / composite)
+  void destroy();
   void draw() const
   {
     glBindVertexArray(vao);
     glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
   }
+
+private:
+  // position(3) + uv(2) + normal(3) per vertex
+  static Mesh upload(const std::vector<float> &verts, const std::vector<unsigned> &idx);
 };
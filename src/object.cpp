@@ -2,54 +2,75 @@
 #include "shader.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 
-void Object::update(float dt, float t)
+void Object::advance(float dt)
 {
   // Accumulate angles based only on dt (no time absolute dependency)
   spinAngle += spinSpeed * dt;
   orbitAngle += orbitSpeed * dt;
+  if (dt != 0.0f && (spinSpeed != 0.0f || (orbitSpeed != 0.0f && orbitRadius > 0.0f)))
+    dirty = true;
+}
 
-  // Rebuild model matrix cleanly each frame (no cumulative errors)
-  model = glm::scale(glm::mat4(1.0f), localScale);
-
-  // Apply rotation around own axis
-  model = glm::rotate(model, spinAngle, axis);
-
-  // Handle orbital movement
+void Object::updateWorld(const glm::mat4 &parentFrame)
+{
+  // Orbit offset around the parent frame's origin (orbitCenter without a target)
+  glm::vec3 offset = orbitTarget ? glm::vec3(0) : orbitCenter;
   if (orbitRadius > 0.0f)
   {
-    glm::vec3 center = orbitTarget ? orbitTarget->position() : orbitCenter;
-    
-    // Create rotation matrix around the specified orbit axis
+    // Unit vector along X, scaled and rotated around the orbit axis
     glm::mat4 R = glm::rotate(glm::mat4(1.0f), orbitAngle, orbitAxis);
-    // Start with unit vector along X and rotate it
-    glm::vec3 offset = glm::vec3(R * glm::vec4(orbitRadius, 0, 0, 1));
-    
-    // Set position (translation part of matrix)
-    model[3] = glm::vec4(center + offset, 1.0f);
+    offset += glm::vec3(R * glm::vec4(orbitRadius, 0, 0, 1));
   }
+
+  // Rebuilt from the angles each time (no cumulative errors)
+  frame = glm::translate(parentFrame, offset);
+  model = glm::rotate(glm::scale(frame, localScale), spinAngle, axis);
+  dirty = false;
 }
 
-void Object::draw(const Shader &sh, const glm::mat4 &VP) const
+glm::mat3 Object::normalMatrix(const glm::mat4 &MV)
 {
+  return glm::transpose(glm::inverse(glm::mat3(MV)));
+}
+
+void Object::draw(const AssetRegistry &a, const Shader &sh, const glm::mat4 &VP) const
+{
+  const Mesh *m = a.get(mesh);
+  const Texture *t = a.get(tex);
+  if (!m || !t)
+    return; // asset unloaded
   sh.use();
   glm::mat4 MVP = VP * model;
   sh.setMat4("MVP", MVP);
-  tex.bind();
-  mesh.draw();
+  t->bind();
+  m->draw();
 }
 
-void Object::draw(const Shader &sh, const glm::mat4 &VP, const glm::mat4 &view, const glm::mat4 &transform) const
+void Object::draw(const AssetRegistry &a, const Shader &sh, const glm::mat4 &VP, const glm::mat4 &view, const glm::mat4 &transform) const
 {
+  const Mesh *m = a.get(mesh);
+  const Texture *t = a.get(tex);
+  if (!m || !t)
+    return; // asset unloaded
   sh.use();
   
   glm::mat4 MV = view * transform * model;
   glm::mat4 MVP = VP * model;
-  glm::mat3 NormalM = glm::transpose(glm::inverse(glm::mat3(MV)));
+  glm::mat3 NormalM = normalMatrix(MV);
   
   sh.setMat4("MVP", MVP);
   sh.setMat4("MV", MV);
   sh.setMat3("NormalM", NormalM);
   
-  tex.bind();
-  mesh.draw();
+  t->bind();
+  m->draw();
+}
+
+void Object::submit(RenderQueue &q, const AssetRegistry &a, const Shader &sh, RenderPass pass,
+                    BlendMode blend, const glm::mat4 &world) const
+{
+  const Mesh *m = a.get(mesh);
+  const Texture *t = a.get(tex);
+  if (m && t)
+    q.submit(pass, blend, sh, t->id(), *m, world);
 }
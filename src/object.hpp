@@ -1,15 +1,19 @@
 #pragma once
 #include "shader.hpp"
-#include "mesh.hpp"
-#include "texture.hpp"
+#include "assets.hpp"
+#include "render_queue.hpp"
 #include <glm/glm.hpp>
+#include <string>
 
 struct Object
 {
-  // Core components
-  Mesh mesh;
-  Texture tex;
-  glm::mat4 model{1.0f};
+  std::string name; // inspector label
+
+  // Core components (shared, owned by the AssetRegistry)
+  MeshHandle mesh;
+  TextureHandle tex;
+  glm::mat4 model{1.0f}; // world (scene root included): frame * scale * spin
+  glm::mat4 frame{1.0f}; // world transform of the orbit frame, which satellites inherit
 
   // Scale properties
   glm::vec3 localScale{1.0f};
@@ -27,12 +31,25 @@ struct Object
   glm::vec3 orbitAxis{0, 1, 0}; // axis around which to orbit (default Y-axis)
   const Object *orbitTarget = nullptr;
 
+  // Transform hierarchy, driven by Scene::update (parents first). The local
+  // transform is the orbit offset (plus orbitCenter at the top level);
+  // frame = parent frame (or the scene root) * local. Satellites inherit
+  // the frame, not the parent's spin or scale.
+  bool dirty = true;  // local inputs changed: rebuild this body and its satellites
+  bool moved = false; // world matrices changed in the last Scene::update
+  void markDirty() { dirty = true; } // after editing radius, axes, scale or angles directly
+
   // Constructor
-  Object(const Mesh& m, const Texture& t) : mesh(m), tex(t) {}
+  Object(MeshHandle m = {}, TextureHandle t = {}) : mesh(m), tex(t) {}
 
   // Methods
-  void update(float dt, float t);
-  void draw(const Shader &sh, const glm::mat4 &VP) const;
-  void draw(const Shader &sh, const glm::mat4 &VP, const glm::mat4 &view, const glm::mat4 &transform) const; // lit version
+  void advance(float dt);                         // accumulate angles; dirty only if they move
+  void updateWorld(const glm::mat4 &parentFrame); // frame and model from local inputs
+  void draw(const AssetRegistry &a, const Shader &sh, const glm::mat4 &VP) const;
+  void draw(const AssetRegistry &a, const Shader &sh, const glm::mat4 &VP, const glm::mat4 &view, const glm::mat4 &transform) const; // lit version
+  void submit(RenderQueue &q, const AssetRegistry &a, const Shader &sh, RenderPass pass, BlendMode blend,
+              const glm::mat4 &world) const; // queued version of draw(); world = transform * model
   glm::vec3 position() const { return glm::vec3(model[3]); }
+
+  static glm::mat3 normalMatrix(const glm::mat4 &MV); // transpose(inverse(mat3(MV)))
 };
@@ -0,0 +1,178 @@
+#include "pose_solver.hpp"
+#include "alloc_counter.hpp"
+#include <opencv2/calib3d.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  cv::Matx33d rodrigues(const cv::Vec3d &r)
+  {
+    double theta = cv::norm(r);
+    if (theta < 1e-12)
+      return cv::Matx33d::eye();
+    cv::Vec3d k = r / theta;
+    double c = std::cos(theta), s = std::sin(theta), v = 1.0 - c;
+    return cv::Matx33d(c + k[0] * k[0] * v, k[0] * k[1] * v - k[2] * s, k[0] * k[2] * v + k[1] * s,
+                       k[1] * k[0] * v + k[2] * s, c + k[1] * k[1] * v, k[1] * k[2] * v - k[0] * s,
+                       k[2] * k[0] * v - k[1] * s, k[2] * k[1] * v + k[0] * s, c + k[2] * k[2] * v);
+  }
+
+  // Geodesic distance between two rotations (radians)
+  double rotationDistance(const cv::Vec3d &a, const cv::Vec3d &b)
+  {
+    cv::Matx33d d = rodrigues(a).t() * rodrigues(b);
+    double tr = d(0, 0) + d(1, 1) + d(2, 2);
+    return std::acos(std::clamp((tr - 1.0) * 0.5, -1.0, 1.0));
+  }
+}
+
+PoseSolver::PoseSolver(const cv::Mat &K, const cv::Mat &dist, float len)
+    : K_(K.clone()), dist_(dist.clone()), fx_(K.at<double>(0, 0))
+{
+  // ArUco corner order (TL, TR, BR, BL) as required by SOLVEPNP_IPPE_SQUARE
+  const float h = len * 0.5f;
+  obj_ = {{-h, h, 0}, {h, h, 0}, {h, -h, 0}, {-h, -h, 0}};
+}
+
+PoseSolver::History *PoseSolver::find(int id)
+{
+  for (History &h : history_)
+    if (h.id == id)
+      return &h;
+  return nullptr;
+}
+
+double PoseSolver::reprojRms(const cv::Vec3d &rvec, const cv::Vec3d &tvec,
+                             const cv::Point2f *pts) const
+{
+  // pts are undistorted, normalised image coordinates
+  cv::Matx33d R = rodrigues(rvec);
+  double sum = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    cv::Vec3d p = R * cv::Vec3d(obj_[i].x, obj_[i].y, obj_[i].z) + tvec;
+    double dx = p[0] / p[2] - pts[i].x, dy = p[1] / p[2] - pts[i].y;
+    sum += dx * dx + dy * dy;
+  }
+  return std::sqrt(sum / 4) * fx_;
+}
+
+void PoseSolver::estimate(const std::vector<int> &ids,
+                          const std::vector<std::vector<cv::Point2f>> &corners,
+                          std::vector<MarkerPose> &out)
+{
+  out.resize(ids.size());
+  if (ids.empty())
+    return;
+
+  // One undistortion call for every corner of every marker
+  flat_.clear();
+  for (const auto &c : corners)
+    flat_.insert(flat_.end(), c.begin(), c.end());
+  {
+    alloc::Exempt ex; // OpenCV-internal temporaries
+    cv::undistortPoints(flat_, norm_, K_, dist_);
+  }
+
+  const cv::Matx33d I = cv::Matx33d::eye();
+  const cv::TermCriteria lm(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 10, 1e-8);
+
+  for (std::size_t m = 0; m < ids.size(); ++m)
+  {
+    const cv::Point2f *pts = &norm_[m * 4];
+    cv::Mat img(4, 1, CV_32FC2, const_cast<cv::Point2f *>(pts));
+    MarkerPose &p = out[m];
+    p.id = ids[m];
+    p.warmStarted = false;
+
+    History *h = find(ids[m]);
+    bool solved = false;
+
+    // Warm start: last frame's pose still explains the corners -> a few LM steps
+    if (h && h->age == 0 && reprojRms(h->rvec, h->tvec, pts) < warmStartPx)
+    {
+      p.rvec = h->rvec;
+      p.tvec = h->tvec;
+      alloc::Exempt ex;
+      cv::solvePnPRefineLM(obj_, img, I, cv::noArray(), p.rvec, p.tvec, lm);
+      p.warmStarted = solved = true;
+    }
+
+    if (!solved)
+    {
+      int n;
+      {
+        alloc::Exempt ex;
+        n = cv::solvePnPGeneric(obj_, img, I, cv::noArray(), rvecs_, tvecs_, false,
+                                cv::SOLVEPNP_IPPE_SQUARE, cv::noArray(), cv::noArray(), errs_);
+      }
+      if (n == 0)
+      {
+        p.id = -1;
+        continue;
+      }
+      int best = 0;
+      if (n > 1)
+      {
+        double e0 = errs_[0], e1 = errs_[1];
+        bool ambiguous = e1 > 0 && e0 / e1 > ambiguityRatio;
+        if (ambiguous && h)
+        {
+          // Both flips fit: keep the one consistent with the marker's history
+          double d0 = rotationDistance(h->rvec, cv::Vec3d(rvecs_[0].ptr<double>()));
+          double d1 = rotationDistance(h->rvec, cv::Vec3d(rvecs_[1].ptr<double>()));
+          best = d1 < d0 ? 1 : 0;
+        }
+      }
+      p.rvec = cv::Vec3d(rvecs_[best].ptr<double>());
+      p.tvec = cv::Vec3d(tvecs_[best].ptr<double>());
+      if (refine)
+      {
+        alloc::Exempt ex;
+        cv::solvePnPRefineLM(obj_, img, I, cv::noArray(), p.rvec, p.tvec, lm);
+      }
+    }
+
+    p.reprojErr = reprojRms(p.rvec, p.tvec, pts);
+    p.view = toGlm(p.rvec, p.tvec);
+  }
+
+  out.erase(std::remove_if(out.begin(), out.end(), [](const MarkerPose &p)
+                           { return p.id < 0; }),
+            out.end());
+}
+
+void PoseSolver::commit(const std::vector<MarkerPose> &poses)
+{
+  for (History &h : history_)
+    ++h.age;
+  for (const MarkerPose &p : poses)
+  {
+    if (History *h = find(p.id))
+      *h = {p.id, p.rvec, p.tvec, 0};
+    else
+      history_.push_back({p.id, p.rvec, p.tvec, 0});
+  }
+  history_.erase(std::remove_if(history_.begin(), history_.end(),
+                                [this](const History &h)
+                                { return h.age > historyFrames; }),
+                 history_.end());
+}
+
+glm::mat4 PoseSolver::toGlm(const cv::Vec3d &rvec, const cv::Vec3d &tvec)
+{
+  cv::Matx33d R = rodrigues(rvec);
+  glm::mat4 V(1.0f);
+  // Column-major, with the OpenCV(+Y down, +Z fwd) -> OpenGL flip folded in
+  for (int c = 0; c < 3; ++c)
+  {
+    V[c][0] = static_cast<float>(R(0, c));
+    V[c][1] = static_cast<float>(-R(1, c));
+    V[c][2] = static_cast<float>(-R(2, c));
+  }
+  V[3][0] = static_cast<float>(tvec[0]);
+  V[3][1] = static_cast<float>(-tvec[1]);
+  V[3][2] = static_cast<float>(-tvec[2]);
+  return V;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct MarkerPose
+{
+  int id{-1};
+  glm::mat4 view{1.0f};  // marker -> camera, OpenGL convention (ARTracker::view())
+  cv::Vec3d rvec, tvec;  // same pose, OpenCV convention
+  double reprojErr{0};   // RMS, pixels
+  bool warmStarted{false};
+};
+
+// Square-marker pose solver.
+// All markers of a frame are undistorted in one batch, then each is solved
+// with IPPE-square (closed form, both planar solutions). The ambiguity is
+// resolved against the marker's previous pose, and when that previous pose
+// still fits the new corners, Levenberg-Marquardt is warm-started from it
+// instead. Output goes straight to glm::mat4.
+class PoseSolver
+{
+public:
+  PoseSolver(const cv::Mat &K, const cv::Mat &dist, float markerLen);
+
+  void solve(const std::vector<int> &ids,
+             const std::vector<std::vector<cv::Point2f>> &corners,
+             std::vector<MarkerPose> &out)
+  {
+    estimate(ids, corners, out);
+    commit(out);
+  }
+  // solve() in two halves, so a caller can vet the poses before they
+  // become the history that disambiguates and warm-starts the next frame
+  void estimate(const std::vector<int> &ids,
+                const std::vector<std::vector<cv::Point2f>> &corners,
+                std::vector<MarkerPose> &out);
+  void commit(const std::vector<MarkerPose> &poses);
+  void reset() { history_.clear(); }
+
+  bool refine = true;            // LM polish after IPPE
+  double warmStartPx = 2.0;      // max reprojection error to reuse last pose
+  double ambiguityRatio = 0.6;   // err(best)/err(second) above this is ambiguous
+  int historyFrames = 10;        // frames a lost marker's pose is remembered
+
+  // Marker pose -> OpenGL view matrix (closed-form Rodrigues, no cv::Mat)
+  static glm::mat4 toGlm(const cv::Vec3d &rvec, const cv::Vec3d &tvec);
+
+private:
+  struct History
+  {
+    int id;
+    cv::Vec3d rvec, tvec;
+    int age; // frames since last seen
+  };
+  History *find(int id);
+  double reprojRms(const cv::Vec3d &rvec, const cv::Vec3d &tvec, const cv::Point2f *pts) const;
+
+  cv::Mat K_, dist_;
+  double fx_;
+  std::vector<cv::Point3f> obj_;
+  std::vector<History> history_;
+
+  // Scratch reused across frames
+  std::vector<cv::Point2f> flat_, norm_;
+  std::vector<cv::Mat> rvecs_, tvecs_;
+  std::vector<double> errs_;
+};
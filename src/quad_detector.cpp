@@ -0,0 +1,348 @@
+#include "quad_detector.hpp"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define QD_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define QD_NEON 1
+#endif
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  double msSince(Clock::time_point t0)
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  }
+
+  // out[x + 1] = prev[x + 1] + sum(src[0..x]); out[0] = 0
+  void integralRow(const uchar *src, const std::uint32_t *prev, std::uint32_t *out, int w)
+  {
+    out[0] = 0;
+    std::uint32_t run = 0;
+    int x = 0;
+#if QD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero; // running total in every lane
+    for (; x + 4 <= w; x += 4)
+    {
+      int px;
+      std::memcpy(&px, src + x, 4);
+      __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(px), zero), zero);
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 4)); // prefix sum across the 4 lanes
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+      v = _mm_add_epi32(v, carry);
+      carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+      __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev + x + 1));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x + 1), _mm_add_epi32(v, above));
+    }
+    run = std::uint32_t(_mm_cvtsi128_si32(carry));
+#elif QD_NEON
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t carry = zero;
+    for (; x + 4 <= w; x += 4)
+    {
+      std::uint32_t px;
+      std::memcpy(&px, src + x, 4);
+      uint32x4_t v = vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(px)))));
+      v = vaddq_u32(v, vextq_u32(zero, v, 3)); // prefix sum across the 4 lanes
+      v = vaddq_u32(v, vextq_u32(zero, v, 2));
+      v = vaddq_u32(v, carry);
+      carry = vdupq_n_u32(vgetq_lane_u32(v, 3));
+      vst1q_u32(out + x + 1, vaddq_u32(v, vld1q_u32(prev + x + 1)));
+    }
+    run = vgetq_lane_u32(carry, 0);
+#endif
+    for (; x < w; ++x)
+    {
+      run += src[x];
+      out[x + 1] = prev[x + 1] + run;
+    }
+  }
+
+  // dst[x] = 1 where src[x] + C <= mean of the (2r + 1)-wide box whose rows
+  // are given by the integral rows A (top, exclusive) and B (bottom).
+  // Boxes are clipped at the image edge; sums wrap in uint32 harmlessly.
+  void thresholdRow(const uchar *src, const std::uint32_t *A, const std::uint32_t *B, int rows,
+                    int r, int w, int C, schar *dst)
+  {
+    auto at = [&](int x)
+    {
+      const int xa = std::max(0, x - r), xb = std::min(w, x + r + 1);
+      const std::uint32_t s = B[xb] - B[xa] - A[xb] + A[xa];
+      dst[x] = float(src[x] + C) * float(rows * (xb - xa)) <= float(s);
+    };
+
+    int x = 0;
+    for (; x < std::min(r, w); ++x)
+      at(x);
+    const int interiorEnd = w - r; // x + r + 1 <= w
+    const float inv = 1.0f / float(rows * (2 * r + 1));
+#if QD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 vInv = _mm_set1_ps(inv), vC = _mm_set1_ps(float(C));
+    auto load = [](const std::uint32_t *p)
+    { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); };
+    for (; x + 4 <= interiorEnd; x += 4)
+    {
+      __m128i s = _mm_sub_epi32(_mm_add_epi32(load(B + x + r + 1), load(A + x - r)),
+                                _mm_add_epi32(load(A + x + r + 1), load(B + x - r)));
+      __m128 mean = _mm_mul_ps(_mm_cvtepi32_ps(s), vInv);
+      int px;
+      std::memcpy(&px, src + x, 4);
+      __m128i p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(px), zero), zero);
+      __m128i m = _mm_castps_si128(_mm_cmple_ps(_mm_add_ps(_mm_cvtepi32_ps(p), vC), mean));
+      m = _mm_packs_epi16(_mm_packs_epi32(m, m), m);
+      int out = _mm_cvtsi128_si32(m) & 0x01010101;
+      std::memcpy(dst + x, &out, 4);
+    }
+#elif QD_NEON
+    const float32x4_t vC = vdupq_n_f32(float(C));
+    for (; x + 4 <= interiorEnd; x += 4)
+    {
+      uint32x4_t s = vsubq_u32(vaddq_u32(vld1q_u32(B + x + r + 1), vld1q_u32(A + x - r)),
+                               vaddq_u32(vld1q_u32(A + x + r + 1), vld1q_u32(B + x - r)));
+      float32x4_t mean = vmulq_n_f32(vcvtq_f32_u32(s), inv);
+      std::uint32_t px;
+      std::memcpy(&px, src + x, 4);
+      uint32x4_t p = vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(px)))));
+      uint32x4_t m = vcleq_f32(vaddq_f32(vcvtq_f32_u32(p), vC), mean);
+      uint16x4_t m16 = vmovn_u32(m);
+      uint8x8_t m8 = vand_u8(vmovn_u16(vcombine_u16(m16, m16)), vdup_n_u8(1));
+      std::uint32_t out = vget_lane_u32(vreinterpret_u32_u8(m8), 0);
+      std::memcpy(dst + x, &out, 4);
+    }
+#else
+    for (; x < interiorEnd; ++x)
+    {
+      const std::uint32_t s = B[x + r + 1] - B[x - r] - A[x + r + 1] + A[x - r];
+      dst[x] = float(src[x] + C) <= float(s) * inv;
+    }
+#endif
+    for (; x < w; ++x)
+      at(x);
+  }
+}
+
+void QuadDetector::thresholdStrip(const cv::Mat &gray, int strip, int strips, int r)
+{
+  const int w = gray.cols, h = gray.rows, iw = w + 1;
+  const int y0 = h * strip / strips, y1 = h * (strip + 1) / strips;
+  const int ys = std::max(0, y0 - r), ye = std::min(h, y1 + r); // image rows the boxes touch
+
+  // Integral over this strip plus the box overlap: strips stay independent
+  std::vector<std::uint32_t> &I = integral_[strip];
+  I.resize(std::size_t(ye - ys + 1) * iw);
+  std::fill_n(I.begin(), iw, 0u);
+  for (int y = ys; y < ye; ++y)
+    integralRow(gray.ptr<uchar>(y), &I[std::size_t(y - ys) * iw], &I[std::size_t(y - ys + 1) * iw], w);
+
+  for (int y = y0; y < y1; ++y)
+  {
+    const int ya = std::max(0, y - r) - ys, yb = std::min(h, y + r + 1) - ys;
+    thresholdRow(gray.ptr<uchar>(y), &I[std::size_t(ya) * iw], &I[std::size_t(yb) * iw], yb - ya, r,
+                 w, params.C, bin_.ptr<schar>(y + 1) + 1);
+  }
+}
+
+void QuadDetector::threshold(const cv::Mat &gray)
+{
+  CV_Assert(gray.type() == CV_8UC1);
+  const int w = gray.cols, h = gray.rows;
+  const int win = params.window > 0 ? params.window : std::max(7, std::min(w, h) / 24);
+  const int r = win / 2;
+
+  bin_.create(h + 2, w + 2, CV_8SC1);
+  bin_.row(0).setTo(0); // zero frame: tracing never leaves the buffer
+  bin_.row(h + 1).setTo(0);
+  bin_.col(0).setTo(0);
+  bin_.col(w + 1).setTo(0);
+
+  // Strips much thinner than the box would mostly recompute each other's rows
+  int strips = params.strips > 0 ? params.strips : std::max(1, cv::getNumThreads());
+  strips = std::clamp(h / (2 * r + 1), 1, strips);
+  if (int(integral_.size()) < strips)
+    integral_.resize(strips);
+  cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range &range)
+                    {
+                      for (int s = range.start; s < range.end; ++s)
+                        thresholdStrip(gray, s, strips, r); });
+}
+
+cv::Mat QuadDetector::binary() const
+{
+  return bin_.empty() ? cv::Mat() : bin_(cv::Rect(1, 1, bin_.cols - 2, bin_.rows - 2));
+}
+
+// Suzuki-Abe border following from `start`; `dir` points at the light
+// neighbour that triggered it (4 = west for outer borders, 0 = east for
+// holes). Marks the border (2, or -2 where its east neighbour is light) so
+// the raster scan does not start it again; keeps the points in contour_.
+void QuadDetector::trace(int start, int dir, bool keep)
+{
+  schar *img = bin_.ptr<schar>(0);
+  const int stride = bin_.cols;
+  // Neighbour offsets, counter-clockwise on screen from east
+  const int d[8] = {1, 1 - stride, -stride, -1 - stride, -1, stride - 1, stride, stride + 1};
+  auto point = [stride](int i)
+  { return cv::Point(i % stride - 1, i / stride - 1); };
+
+  contour_.clear();
+  int s = dir, i1;
+  do
+  {
+    s = (s - 1) & 7;
+    i1 = start + d[s];
+  } while (img[i1] == 0 && s != dir);
+  if (s == dir) // isolated pixel
+  {
+    img[start] = -2;
+    if (keep)
+      contour_.push_back(point(start));
+    return;
+  }
+
+  for (int i3 = start;;)
+  {
+    const int sEnd = s;
+    int i4;
+    do
+      i4 = i3 + d[++s & 7];
+    while (img[i4] == 0);
+    s &= 7;
+    if (unsigned(s - 1) < unsigned(sEnd)) // east neighbour was examined and light
+      img[i3] = -2;
+    else if (img[i3] == 1)
+      img[i3] = 2;
+    if (keep)
+      contour_.push_back(point(i3));
+    if (i4 == start && i3 == i1)
+      break;
+    i3 = i4;
+    s = (s + 4) & 7;
+  }
+}
+
+bool QuadDetector::fitQuad(std::vector<cv::Point2f> &quad, int w, int h)
+{
+  cv::approxPolyDP(contour_, approx_, double(contour_.size()) * params.polyAccuracyRate, true);
+  if (approx_.size() != 4 || !cv::isContourConvex(approx_))
+    return false;
+
+  const double minSide = double(contour_.size()) * params.minCornerDistRate;
+  const int b = params.minBorderDist;
+  for (int k = 0; k < 4; ++k)
+  {
+    const cv::Point p = approx_[k], e = approx_[(k + 1) & 3] - p;
+    if (double(e.dot(e)) < minSide * minSide)
+      return false;
+    if (p.x < b || p.y < b || p.x > w - 1 - b || p.y > h - 1 - b)
+      return false;
+  }
+
+  quad.assign(approx_.begin(), approx_.end());
+  // Clockwise on screen, as ArUco orders its candidates
+  cv::Point2f a = quad[1] - quad[0], c = quad[2] - quad[0];
+  if (a.x * c.y - a.y * c.x < 0)
+    std::swap(quad[1], quad[3]);
+  return true;
+}
+
+bool QuadDetector::decode(const cv::Mat &gray, std::vector<cv::Point2f> &quad, int &id)
+{
+  // Same sampling as ArUco: 4 px per cell, nearest neighbour, Otsu
+  const int n = dict_.markerSize, cell = 4, size = (n + 2) * cell;
+  const float e = float(size - 1);
+  const cv::Point2f square[4] = {{0, 0}, {e, 0}, {e, e}, {0, e}};
+  cv::warpPerspective(gray, warped_, cv::getPerspectiveTransform(quad.data(), square),
+                      cv::Size(size, size), cv::INTER_NEAREST);
+
+  cv::Scalar mean, dev;
+  cv::meanStdDev(warped_(cv::Rect(cell / 2, cell / 2, size - cell, size - cell)), mean, dev);
+  if (dev[0] < 5.0)
+    return false; // flat patch: no bits to read
+  cv::threshold(warped_, warped_, 125, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+
+  bits_.create(n + 2, n + 2, CV_8UC1);
+  int borderErr = 0;
+  for (int cy = 0; cy < n + 2; ++cy)
+    for (int cx = 0; cx < n + 2; ++cx)
+    {
+      int white = 0;
+      for (int y = 0; y < cell; ++y)
+      {
+        const uchar *row = warped_.ptr<uchar>(cy * cell + y) + cx * cell;
+        for (int x = 0; x < cell; ++x)
+          white += row[x] != 0;
+      }
+      const uchar bit = white > cell * cell / 2;
+      bits_.at<uchar>(cy, cx) = bit;
+      if (bit && (cy == 0 || cx == 0 || cy == n + 1 || cx == n + 1))
+        ++borderErr;
+    }
+  if (borderErr > int(n * n * params.maxBorderErrRate))
+    return false;
+
+  bits_(cv::Rect(1, 1, n, n)).copyTo(onlyBits_);
+  int rotation;
+  if (!dict_.identify(onlyBits_, id, rotation, params.errorCorrectionRate))
+    return false;
+  std::rotate(quad.begin(), quad.begin() + 4 - rotation, quad.end());
+  return true;
+}
+
+void QuadDetector::detect(const cv::Mat &gray, std::vector<std::vector<cv::Point2f>> &corners,
+                          std::vector<int> &ids)
+{
+  corners.clear();
+  ids.clear();
+  stats_ = {};
+
+  auto t0 = Clock::now();
+  threshold(gray);
+  stats_.thresholdMs = msSince(t0);
+
+  const int w = gray.cols, h = gray.rows, stride = bin_.cols;
+  const std::size_t minLen = std::size_t(params.minPerimeterRate * std::max(w, h));
+  const std::size_t maxLen = std::size_t(params.maxPerimeterRate * std::max(w, h));
+  double decodeMs = 0;
+  t0 = Clock::now();
+  for (int y = 1; y <= h; ++y)
+  {
+    const schar *row = bin_.ptr<schar>(y);
+    for (int x = 1; x <= w + 1; ++x) // x = w + 1: the frame closes holes on the right edge
+    {
+      const schar prev = row[x - 1], cur = row[x];
+      if (prev == cur)
+        continue;
+      if (prev == 0 && cur == 1) // outer border of a dark region
+      {
+        trace(y * stride + x, 4, true);
+        ++stats_.contours;
+        if (contour_.size() < minLen || contour_.size() > maxLen || !fitQuad(quad_, w, h))
+          continue;
+        ++stats_.quads;
+        auto td = Clock::now();
+        int id;
+        if (decode(gray, quad_, id))
+        {
+          corners.push_back(quad_);
+          ids.push_back(id);
+        }
+        decodeMs += msSince(td);
+      }
+      else if (cur == 0 && prev >= 1) // hole border: traced only to mark it
+        trace(y * stride + x - 1, 0, false);
+    }
+  }
+  stats_.contourMs = msSince(t0) - decodeMs;
+  stats_.decodeMs = decodeMs;
+  stats_.markers = int(ids.size());
+}
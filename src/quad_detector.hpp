@@ -0,0 +1,63 @@
+#pragma once
+#include <opencv2/aruco.hpp>
+#include <cstdint>
+#include <vector>
+
+struct QuadDetectorParams
+{
+  int window = 0;                  // adaptive threshold box (px); 0: min(w, h) / 24, at least 7
+  int C = 7;                       // dark = at least this far below the box mean
+  int strips = 0;                  // threshold strips; 0: one per OpenCV worker thread
+  float minPerimeterRate = 0.03f;  // contour length vs. max(w, h), as ArUco
+  float maxPerimeterRate = 4.0f;
+  float polyAccuracyRate = 0.03f;  // approxPolyDP epsilon vs. contour length
+  float minCornerDistRate = 0.05f; // shortest side vs. contour length
+  int minBorderDist = 3;           // px between a corner and the image edge
+  float maxBorderErrRate = 0.35f;  // white border cells allowed, vs. marker bits
+  float errorCorrectionRate = 0.6f;
+};
+
+struct QuadDetectorStats
+{
+  double thresholdMs{0}, contourMs{0}, decodeMs{0}; // last detect()
+  int contours{0}, quads{0}, markers{0};
+};
+
+// Marker candidate front end, standing in for ArucoDetector's thresholding
+// and contour search:
+//   1. a single adaptive threshold from an integral image, computed in
+//      horizontal strips on OpenCV's worker threads; the integral rows and
+//      the box test are vectorised (SSE2 / NEON, scalar elsewhere)
+//   2. border following (Suzuki-Abe) over the binary image, keeping outer
+//      borders only
+//   3. quad fitting and filtering with ArUco's default rates
+// Quads are read into bits and identified with the tracker's Dictionary, so
+// ids and corner order match detectMarkers() and go to PoseSolver as they are.
+// Not thread-safe; buffers are reused across frames.
+class QuadDetector
+{
+public:
+  explicit QuadDetector(const cv::aruco::Dictionary &dict) : dict_(dict) {}
+
+  void detect(const cv::Mat &gray, std::vector<std::vector<cv::Point2f>> &corners,
+              std::vector<int> &ids);
+  void threshold(const cv::Mat &gray); // step 1 alone (benchmarks)
+  cv::Mat binary() const;              // last threshold, nonzero = dark
+
+  QuadDetectorParams params;
+  const QuadDetectorStats &stats() const { return stats_; }
+
+private:
+  void thresholdStrip(const cv::Mat &gray, int strip, int strips, int r);
+  void trace(int start, int dir, bool keep);
+  bool fitQuad(std::vector<cv::Point2f> &quad, int w, int h);
+  bool decode(const cv::Mat &gray, std::vector<cv::Point2f> &quad, int &id);
+
+  cv::aruco::Dictionary dict_;
+  cv::Mat bin_; // CV_8S, (h + 2) x (w + 2) with a zero frame: 0 light, 1 dark, +-2 traced
+  std::vector<std::vector<std::uint32_t>> integral_; // per strip, grows only
+  std::vector<cv::Point> contour_, approx_;
+  std::vector<cv::Point2f> quad_;
+  cv::Mat warped_, bits_, onlyBits_;
+  QuadDetectorStats stats_;
+};
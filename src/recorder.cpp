@@ -0,0 +1,197 @@
+#include "recorder.hpp"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cstring>
+#include "logger.hpp"
+
+FrameRecorder::FrameRecorder(int pboCount, int queueDepth, DropPolicy policy)
+    : pboCount_(pboCount), queueDepth_(queueDepth), policy_(policy)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+  stop();
+}
+
+bool FrameRecorder::start(const std::string &path, int w, int h, double fps)
+{
+  if (recording_)
+    return true;
+
+  bool avi = path.size() > 4 && path.compare(path.size() - 4, 4, ".avi") == 0;
+  int fourcc = avi ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G')
+                   : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+  if (!writer_.open(path, fourcc, fps, cv::Size(w, h)))
+  {
+    LOG_ERR("Recorder: cannot open %s", path.c_str());
+    return false;
+  }
+
+  w_ = w;
+  h_ = h;
+  path_ = path;
+  const std::size_t bytes = std::size_t(w) * h * 4;
+
+  pbos_.assign(pboCount_, 0);
+  pending_.assign(pboCount_, false);
+  head_ = 0;
+  glGenBuffers(pboCount_, pbos_.data());
+  for (GLuint pbo : pbos_)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  pool_.assign(queueDepth_, std::vector<std::uint8_t>(bytes));
+  free_.reset(queueDepth_); // a slot is in at most one queue: depth is enough
+  ready_.reset(queueDepth_);
+  for (int i = 0; i < queueDepth_; ++i)
+    free_.push_back(i);
+
+  captured_ = 0;
+  encoded_ = 0;
+  dropped_ = 0;
+  quit_ = false;
+  encoder_ = std::thread(&FrameRecorder::encodeLoop, this);
+  recording_ = true;
+  LOG_INF("Recording %dx%d to %s", w, h, path.c_str());
+  return true;
+}
+
+void FrameRecorder::stop()
+{
+  if (!recording_)
+    return;
+
+  // Drain PBOs still in flight, oldest first
+  for (int i = 0; i < pboCount_; ++i)
+  {
+    int idx = (head_ + i) % pboCount_;
+    if (pending_[idx])
+      consume(idx);
+  }
+  glDeleteBuffers(pboCount_, pbos_.data());
+  pbos_.clear();
+
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    quit_ = true;
+  }
+  cv_.notify_one();
+  encoder_.join();
+  writer_.release();
+  recording_ = false;
+  LOG_INF("Recording stopped: %llu encoded, %llu dropped",
+          (unsigned long long)encoded_.load(), (unsigned long long)dropped_.load());
+}
+
+void FrameRecorder::capture(int w, int h, GLuint fbo)
+{
+  if (!recording_)
+    return;
+  if (w != w_ || h != h_)
+  {
+    LOG_ERR("Recorder: framebuffer resized to %dx%d (recording %dx%d), stopping", w, h, w_, h_);
+    stop(); // frames already read back are still w_ x h_ and get flushed
+    return;
+  }
+
+  // This PBO was filled pboCount_ frames ago; its transfer is long done
+  if (pending_[head_])
+    consume(head_);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[head_]);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, w_, h_, GL_BGRA, GL_UNSIGNED_BYTE, nullptr); // async into PBO
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  pending_[head_] = true;
+  head_ = (head_ + 1) % pboCount_;
+  ++captured_;
+}
+
+void FrameRecorder::consume(int pbo)
+{
+  pending_[pbo] = false;
+
+  int slot = -1;
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!free_.empty())
+    {
+      slot = free_.front();
+      free_.pop_front();
+    }
+    else if (policy_ == DropPolicy::DropOldest && !ready_.empty())
+    {
+      slot = ready_.front(); // steal the oldest queued frame
+      ready_.pop_front();
+      ++dropped_;
+    }
+  }
+  if (slot < 0)
+  {
+    ++dropped_; // DropNewest: leave the PBO unread
+    return;
+  }
+
+  const std::size_t bytes = std::size_t(w_) * h_ * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[pbo]);
+  if (void *src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT))
+  {
+    std::memcpy(pool_[slot].data(), src, bytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    ready_.push_back(slot);
+  }
+  cv_.notify_one();
+}
+
+void FrameRecorder::encodeLoop()
+{
+  cv::Mat flipped, bgr;
+  for (;;)
+  {
+    int slot;
+    {
+      std::unique_lock<std::mutex> lk(mtx_);
+      cv_.wait(lk, [this]
+               { return quit_ || !ready_.empty(); });
+      if (ready_.empty())
+        return; // quit_ and fully drained
+      slot = ready_.front();
+      ready_.pop_front();
+    }
+
+    // GL rows are bottom-up; the writer wants top-down BGR
+    cv::Mat bgra(h_, w_, CV_8UC4, pool_[slot].data());
+    cv::flip(bgra, flipped, 0);
+    cv::cvtColor(flipped, bgr, cv::COLOR_BGRA2BGR);
+    writer_.write(bgr);
+    ++encoded_;
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    free_.push_back(slot);
+  }
+}
+
+RecorderStats FrameRecorder::stats() const
+{
+  RecorderStats s;
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    s.queueDepth = static_cast<int>(ready_.size());
+  }
+  s.queueCapacity = queueDepth_;
+  s.captured = captured_;
+  s.encoded = encoded_;
+  s.dropped = dropped_;
+  return s;
+}
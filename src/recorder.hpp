@@ -0,0 +1,87 @@
+#pragma once
+#include <glad/glad.h>
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What to do when the encoder falls behind and the frame queue is full
+enum class DropPolicy
+{
+  DropNewest, // discard the frame just read back
+  DropOldest, // overwrite the oldest queued frame
+};
+
+struct RecorderStats
+{
+  int queueDepth{0};    // frames waiting for the encoder
+  int queueCapacity{0};
+  std::uint64_t captured{0};
+  std::uint64_t encoded{0};
+  std::uint64_t dropped{0};
+};
+
+// Non-stalling session recorder.
+// capture() issues glReadPixels into a ring of PBOs and maps each one
+// pboCount frames later, so the readback never waits on the GPU. Mapped
+// pixels are copied into a fixed pool of frame buffers and handed to an
+// encoder thread (cv::VideoWriter) through a bounded queue.
+class FrameRecorder
+{
+public:
+  explicit FrameRecorder(int pboCount = 3, int queueDepth = 8,
+                         DropPolicy policy = DropPolicy::DropOldest);
+  ~FrameRecorder();
+
+  bool start(const std::string &path, int w, int h, double fps = 30.0);
+  void stop(); // flushes in-flight PBOs and queued frames
+  bool recording() const { return recording_; }
+  const std::string &path() const { return path_; }
+
+  // Call once per frame, before swap, with the framebuffer's current size.
+  // A video keeps the size it was started with, so a resize stops recording.
+  void capture(int w, int h, GLuint fbo = 0);
+  RecorderStats stats() const;
+
+private:
+  void consume(int pbo); // map + enqueue a filled PBO
+  void encodeLoop();
+
+  int pboCount_, queueDepth_;
+  DropPolicy policy_;
+  std::vector<GLuint> pbos_;
+  std::vector<bool> pending_;
+  int head_{0};
+  int w_{0}, h_{0};
+  bool recording_{false};
+  std::string path_;
+
+  // FIFO of pool slot indices over fixed storage; never allocates after reset()
+  struct SlotQueue
+  {
+    std::vector<int> buf;
+    int head{0}, count{0};
+
+    void reset(int capacity) { buf.assign(capacity, -1); head = count = 0; }
+    bool empty() const { return count == 0; }
+    std::size_t size() const { return std::size_t(count); }
+    int front() const { return buf[head]; }
+    void pop_front() { head = (head + 1) % int(buf.size()); --count; }
+    void push_back(int v) { buf[(head + count++) % int(buf.size())] = v; }
+  };
+
+  std::vector<std::vector<std::uint8_t>> pool_; // preallocated BGRA frames
+  SlotQueue free_, ready_;
+  mutable std::mutex mtx_;
+  std::condition_variable cv_;
+  bool quit_{false};
+  std::thread encoder_;
+  cv::VideoWriter writer_;
+
+  std::uint64_t captured_{0};
+  std::atomic<std::uint64_t> encoded_{0}, dropped_{0};
+};
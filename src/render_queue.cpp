@@ -0,0 +1,215 @@
+#include "render_queue.hpp"
+#include "shader.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include <algorithm>
+
+namespace
+{
+  constexpr int kDepthBits = 24;
+  constexpr int kMeshBits = 11;
+  constexpr int kTexBits = 14;
+  constexpr int kProgBits = 10;
+  constexpr int kBlendBits = 2;
+
+  constexpr int kMeshShift = kDepthBits;
+  constexpr int kTexShift = kMeshShift + kMeshBits;
+  constexpr int kProgShift = kTexShift + kTexBits;
+  constexpr int kBlendShift = kProgShift + kProgBits;
+  constexpr int kPassShift = kBlendShift + kBlendBits;
+
+  constexpr std::uint64_t field(std::uint64_t v, int bits, int shift)
+  {
+    return (v & ((std::uint64_t(1) << bits) - 1)) << shift;
+  }
+
+  void applyPass(RenderPass pass)
+  {
+    switch (pass)
+    {
+    case RenderPass::Background:
+      glDisable(GL_DEPTH_TEST);
+      glDisable(GL_CULL_FACE);
+      glDepthMask(GL_TRUE);
+      break;
+    case RenderPass::Opaque:
+      glEnable(GL_DEPTH_TEST);
+      glEnable(GL_CULL_FACE);
+      glDepthMask(GL_TRUE);
+      break;
+    case RenderPass::Composite:
+      glDisable(GL_DEPTH_TEST);
+      glDisable(GL_CULL_FACE);
+      glDepthMask(GL_TRUE);
+      break;
+    }
+  }
+
+  void applyBlend(BlendMode blend)
+  {
+    if (blend == BlendMode::None)
+    {
+      glDisable(GL_BLEND);
+      return;
+    }
+    glEnable(GL_BLEND);
+    if (blend == BlendMode::Premultiplied)
+      glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    else // alpha channel keeps coverage so offscreen layers come out premultiplied
+      glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  }
+}
+
+std::uint64_t RenderQueue::makeKey(RenderPass pass, BlendMode blend, GLuint program,
+                                   GLuint texture, GLuint vao, float depth)
+{
+  // Quantise view depth. Opaque items sort by state, depth breaking ties
+  // front-to-back; blended items need strict back-to-front order, so their
+  // inverted depth moves up right below the blend field and state drops
+  // into the low bits.
+  float d = std::clamp(depth / kMaxDepth, 0.0f, 1.0f);
+  std::uint64_t q = static_cast<std::uint64_t>(d * float((1u << kDepthBits) - 1));
+  std::uint64_t head = field(static_cast<std::uint64_t>(pass), 3, kPassShift) |
+                       field(static_cast<std::uint64_t>(blend), kBlendBits, kBlendShift);
+  if (blend != BlendMode::None)
+  {
+    q = ((std::uint64_t(1) << kDepthBits) - 1) - q;
+    return head |
+           field(q, kDepthBits, kBlendShift - kDepthBits) |
+           field(program, kProgBits, kTexBits + kMeshBits) |
+           field(texture, kTexBits, kMeshBits) |
+           field(vao, kMeshBits, 0);
+  }
+
+  return head |
+         field(program, kProgBits, kProgShift) |
+         field(texture, kTexBits, kTexShift) |
+         field(vao, kMeshBits, kMeshShift) |
+         field(q, kDepthBits, 0);
+}
+
+void RenderQueue::setView(const glm::mat4 &view, const glm::mat4 &proj)
+{
+  view_ = view;
+  proj_ = proj;
+}
+
+void RenderQueue::beginFrame()
+{
+  lastStats_ = stats_;
+  stats_ = RenderStats{};
+}
+
+void RenderQueue::setStereo(const glm::mat4 eyeProj[2])
+{
+  eyeProj_[0] = eyeProj[0];
+  eyeProj_[1] = eyeProj[1];
+  stereo_ = true;
+}
+
+void RenderQueue::submit(RenderPass pass, BlendMode blend, const Shader &sh, GLuint texture,
+                         const Mesh &mesh, const glm::mat4 &model)
+{
+  float depth = -(view_ * model[3]).z; // view looks down -Z
+  DrawItem item;
+  item.key = makeKey(pass, blend, sh.id(), texture, mesh.vao, depth);
+  item.shader = &sh;
+  item.texture = texture;
+  item.mesh = &mesh;
+  item.model = model;
+  items_.push_back(item);
+}
+
+void RenderQueue::execute()
+{
+  std::sort(items_.begin(), items_.end(),
+            [](const DrawItem &a, const DrawItem &b)
+            { return a.key < b.key; });
+
+  const glm::mat4 VP = proj_ * view_;
+
+  int curPass = -1, curBlend = -1;
+  const Shader *curShader = nullptr;
+  GLuint curTex = 0, curVao = 0;
+  bool texBound = false, vaoBound = false;
+  GLint locMVP = -1, locMV = -1, locNormal = -1;
+
+  glActiveTexture(GL_TEXTURE0);
+  bool instanced = false;
+
+  for (const DrawItem &it : items_)
+  {
+    int pass = static_cast<int>(it.key >> kPassShift);
+    int blend = static_cast<int>((it.key >> kBlendShift) & ((1u << kBlendBits) - 1));
+    if (pass != curPass)
+    {
+      applyPass(static_cast<RenderPass>(pass));
+      curPass = pass;
+      ++stats_.stateChanges;
+
+      bool inst = stereo_ && pass != static_cast<int>(RenderPass::Composite);
+      if (inst != instanced)
+      {
+        if (inst)
+          glEnable(GL_CLIP_DISTANCE0); // seam between the two eye halves
+        else
+          glDisable(GL_CLIP_DISTANCE0);
+        instanced = inst;
+      }
+    }
+    if (blend != curBlend)
+    {
+      applyBlend(static_cast<BlendMode>(blend));
+      curBlend = blend;
+      ++stats_.stateChanges;
+    }
+
+    if (it.shader != curShader)
+    {
+      it.shader->use();
+      curShader = it.shader;
+      locMVP = it.shader->uniform("MVP");
+      locMV = it.shader->uniform("MV");
+      locNormal = it.shader->uniform("NormalM");
+      if (stereo_)
+        glUniformMatrix4fv(it.shader->uniform("uEyeProj"), 2, GL_FALSE, &eyeProj_[0][0][0]);
+      ++stats_.programBinds;
+    }
+    if (!texBound || it.texture != curTex)
+    {
+      glBindTexture(GL_TEXTURE_2D, it.texture);
+      curTex = it.texture;
+      texBound = true;
+      ++stats_.textureBinds;
+    }
+    if (!vaoBound || it.mesh->vao != curVao)
+    {
+      glBindVertexArray(it.mesh->vao);
+      curVao = it.mesh->vao;
+      vaoBound = true;
+      ++stats_.vaoBinds;
+    }
+
+    glm::mat4 MVP = VP * it.model;
+    glUniformMatrix4fv(locMVP, 1, GL_FALSE, &MVP[0][0]);
+    if (locMV >= 0 || locNormal >= 0)
+    {
+      glm::mat4 MV = view_ * it.model;
+      glm::mat3 NormalM = Object::normalMatrix(MV);
+      glUniformMatrix4fv(locMV, 1, GL_FALSE, &MV[0][0]);
+      glUniformMatrix3fv(locNormal, 1, GL_FALSE, &NormalM[0][0]);
+    }
+
+    if (instanced)
+      glDrawElementsInstanced(GL_TRIANGLES, it.mesh->indexCount, GL_UNSIGNED_INT, 0, 2);
+    else
+      glDrawElements(GL_TRIANGLES, it.mesh->indexCount, GL_UNSIGNED_INT, 0);
+    ++stats_.draws;
+  }
+
+  // Leave state the way the rest of the frame (glClear, ImGui) expects it
+  glDepthMask(GL_TRUE);
+  glDisable(GL_BLEND);
+  glDisable(GL_CLIP_DISTANCE0);
+  items_.clear();
+}
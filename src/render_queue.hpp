@@ -0,0 +1,81 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Shader;
+struct Mesh;
+
+// Passes execute in enum order; each pass owns its depth/cull state
+enum class RenderPass : std::uint8_t
+{
+  Background = 0, // no depth test, no culling
+  Opaque = 1,     // depth test + write, back-face culling
+  Composite = 2,  // full-screen layers: no depth test, never instanced
+};
+
+enum class BlendMode : std::uint8_t
+{
+  None = 0,
+  Alpha = 1,         // SRC_ALPHA, ONE_MINUS_SRC_ALPHA (alpha channel accumulates coverage)
+  Premultiplied = 2, // ONE, ONE_MINUS_SRC_ALPHA
+};
+
+struct DrawItem
+{
+  std::uint64_t key{0};
+  const Shader *shader{nullptr};
+  GLuint texture{0};
+  const Mesh *mesh{nullptr};
+  glm::mat4 model{1.0f}; // full model matrix (system transform included)
+};
+
+struct RenderStats
+{
+  int draws{0};
+  int programBinds{0};
+  int textureBinds{0};
+  int vaoBinds{0};
+  int stateChanges{0}; // pass / blend transitions
+};
+
+// Sorted draw submission. Items are collected during the frame, sorted once
+// by a 64-bit key and executed with redundant-bind filtering.
+//
+// Key layout (MSB -> LSB):
+//   pass:3 | blend:2 | program:10 | texture:14 | mesh:11 | depth:24
+// Blended items (back-to-front, depth inverted):
+//   pass:3 | blend:2 | depth:24 | program:10 | texture:14 | mesh:11
+// GL names are masked into their fields; a collision only costs an extra
+// bind, never a wrong one, since items carry the real names.
+class RenderQueue
+{
+public:
+  static std::uint64_t makeKey(RenderPass pass, BlendMode blend, GLuint program,
+                               GLuint texture, GLuint vao, float depth);
+
+  void setView(const glm::mat4 &view, const glm::mat4 &proj);
+  // Single-pass stereo: every item is drawn as 2 instances (one per eye)
+  // with uEyeProj[2] uploaded once per program. Use the STEREO_* shaders.
+  void setStereo(const glm::mat4 eyeProj[2]);
+  void setMono() { stereo_ = false; }
+  bool stereo() const { return stereo_; }
+  void submit(RenderPass pass, BlendMode blend, const Shader &sh, GLuint texture,
+              const Mesh &mesh, const glm::mat4 &model);
+  void beginFrame(); // publish the previous frame's stats, start counting anew
+  void execute();    // sort, draw and clear; GL is left with depth write on, blend off
+  void clear() { items_.clear(); }
+
+  std::size_t size() const { return items_.size(); }
+  const RenderStats &stats() const { return lastStats_; } // all executes of the last frame
+
+  static constexpr float kMaxDepth = 100.0f; // matches the tracker far plane
+
+private:
+  std::vector<DrawItem> items_;
+  glm::mat4 view_{1.0f}, proj_{1.0f};
+  glm::mat4 eyeProj_[2]{glm::mat4(1.0f), glm::mat4(1.0f)};
+  bool stereo_{false};
+  RenderStats stats_, lastStats_;
+};
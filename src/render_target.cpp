@@ -0,0 +1,61 @@
+#include "render_target.hpp"
+#include "logger.hpp"
+
+void RenderTarget::ensure(int w, int h)
+{
+  if (fbo_ && w <= w_ && h <= h_)
+    return;
+  destroy();
+  w_ = w;
+  h_ = h;
+
+  glGenFramebuffers(1, &fbo_);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+  GLenum bufs[kMaxColors];
+  glGenTextures(colors_, color_);
+  for (int i = 0; i < colors_; ++i)
+  {
+    glBindTexture(GL_TEXTURE_2D, color_[i]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, color_[i], 0);
+    bufs[i] = GL_COLOR_ATTACHMENT0 + i;
+  }
+  glDrawBuffers(colors_, bufs);
+
+  if (hasDepth_)
+  {
+    glGenRenderbuffers(1, &depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+  }
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    LOG_ERR("Render target %dx%d incomplete", w, h);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  LOG_INF("Render target allocated: %dx%d", w, h);
+}
+
+void RenderTarget::bind(int vw, int vh)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glViewport(0, 0, vw, vh);
+}
+
+void RenderTarget::destroy()
+{
+  if (fbo_)
+    glDeleteFramebuffers(1, &fbo_);
+  if (color_[0])
+    glDeleteTextures(colors_, color_);
+  if (depth_)
+    glDeleteRenderbuffers(1, &depth_);
+  fbo_ = depth_ = 0;
+  for (GLuint &c : color_)
+    c = 0;
+  w_ = h_ = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <glad/glad.h>
+
+// Offscreen target: up to kMaxColors RGBA8 textures (MRT) + optional depth renderbuffer.
+// Storage only grows; callers render into a sub-rectangle via bind(),
+// so changing the render scale every frame never reallocates.
+class RenderTarget
+{
+public:
+  static constexpr int kMaxColors = 2;
+
+  explicit RenderTarget(int colors = 1, bool depth = true) : colors_(colors), hasDepth_(depth) {}
+  RenderTarget(const RenderTarget &) = delete;
+  RenderTarget &operator=(const RenderTarget &) = delete;
+
+  void ensure(int w, int h);              // (re)allocate if smaller than w x h
+  void bind(int vw, int vh);              // bind FBO, set viewport to vw x vh
+  void destroy();
+
+  GLuint fbo() const { return fbo_; }
+  GLuint color(int i = 0) const { return color_[i]; }
+  int width() const { return w_; }
+  int height() const { return h_; }
+
+private:
+  int colors_;
+  bool hasDepth_;
+  GLuint fbo_{}, color_[kMaxColors]{}, depth_{};
+  int w_{0}, h_{0};
+};
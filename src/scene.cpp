@@ -1,23 +1,34 @@
 #include "scene.hpp"
 #include "object.hpp"
-#include <glm/gtc/matrix_transform.hpp>
 
-void Scene::update(float dt, float t)
+void Scene::update(float dt, float)
 {
-  for (auto *o : objects_)
-    o->update(dt, t);
-    
-  // Tilt orbital plane 20 degrees so Earth doesn't hide behind Sun
-  glm::mat4 tilt = glm::rotate(glm::mat4(1.0f),
-                               glm::radians(-20.f),   // 20° around X axis
-                               glm::vec3(1, 0, 0));
-  
-  for (auto *o : objects_)
-    o->model = tilt * o->model;
+  rebuilt_ = 0;
+  for (Object *o : objects_)
+  {
+    o->advance(dt);
+    const Object *p = o->orbitTarget; // already updated: parents come first
+    if (o->dirty || (p ? p->moved : rootDirty_))
+    {
+      o->updateWorld(p ? p->frame : root_);
+      o->moved = true;
+      ++rebuilt_;
+    }
+    else
+      o->moved = false;
+  }
+  rootDirty_ = false;
+}
+
+void Scene::snapshot(std::vector<glm::mat4> &models) const
+{
+  models.resize(objects_.size());
+  for (std::size_t i = 0; i < objects_.size(); ++i)
+    models[i] = objects_[i]->model;
 }
 
-void Scene::draw(const Shader &sh, const glm::mat4 &VP)
+void Scene::draw(const AssetRegistry &a, const Shader &sh, const glm::mat4 &VP)
 {
   for (auto *o : objects_)
-    o->draw(sh, VP);
+    o->draw(a, sh, VP);
 }
@@ -4,14 +4,34 @@
 
 struct Object;
 class Shader;
+class AssetRegistry;
 
+// Bodies in parent-first order (an orbitTarget is added before its
+// satellites) under one root transform. update() advances every body and
+// rebuilds world matrices only for dirty bodies and their descendants, so a
+// static or paused scene costs a flag check per body.
 class Scene
 {
 public:
   void add(Object *o) { objects_.push_back(o); }
+  const std::vector<Object *> &objects() const { return objects_; }
+
+  // Scene-wide transform above every top-level body (tilt, scale)
+  void setRoot(const glm::mat4 &m)
+  {
+    root_ = m;
+    rootDirty_ = true;
+  }
+  const glm::mat4 &root() const { return root_; }
+
   void update(float dt, float t);
-  void draw(const Shader &sh, const glm::mat4 &VP);
+  int rebuilt() const { return rebuilt_; } // bodies whose world changed in the last update
+  void snapshot(std::vector<glm::mat4> &models) const; // every body's model, scene order
+  void draw(const AssetRegistry &a, const Shader &sh, const glm::mat4 &VP);
 
 private:
   std::vector<Object *> objects_;
+  glm::mat4 root_{1.0f};
+  bool rootDirty_{true};
+  int rebuilt_{0};
 };
@@ -29,12 +29,22 @@ Shader::Shader(const char *vsSrc, const char *fsSrc)
   glDeleteShader(fs);
 }
 
+GLint Shader::uniform(const char *n) const
+{
+  auto it = locs_.find(n);
+  if (it != locs_.end())
+    return it->second;
+  GLint loc = glGetUniformLocation(id_, n);
+  locs_.emplace(n, loc);
+  return loc;
+}
+
 void Shader::setMat4(const char *n, const glm::mat4 &m) const
 {
-  glUniformMatrix4fv(glGetUniformLocation(id_, n), 1, GL_FALSE, &m[0][0]);
+  glUniformMatrix4fv(uniform(n), 1, GL_FALSE, &m[0][0]);
 }
 
 void Shader::setMat3(const char *n, const glm::mat3 &m) const
 {
-  glUniformMatrix3fv(glGetUniformLocation(id_, n), 1, GL_FALSE, &m[0][0]);
+  glUniformMatrix3fv(uniform(n), 1, GL_FALSE, &m[0][0]);
 }
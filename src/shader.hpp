@@ -1,6 +1,8 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
 
 class Shader
 {
@@ -9,9 +11,11 @@ public:
   void use() const { glUseProgram(id_); }
   void setMat4(const char *n, const glm::mat4 &m) const;
   void setMat3(const char *n, const glm::mat3 &m) const;
+  GLint uniform(const char *n) const; // cached glGetUniformLocation
   GLuint id() const { return id_; }
 
 private:
   GLuint id_;
+  mutable std::unordered_map<std::string, GLint> locs_;
   static GLuint compile(GLenum type, const char *src);
 };
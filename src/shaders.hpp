@@ -0,0 +1,362 @@
+#pragma once
+// GLSL sources shared by the live app and the offline renderer
+
+static const char *VSHADER = R"(
+#version 410 core
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aUV;
+uniform mat4 MVP;
+out vec2 vUV;
+void main(){ vUV=aUV; gl_Position=MVP*vec4(aPos,1.0); }
+)";
+
+// Opaque: the marker fade is applied once, in the composite.
+// Location 1 is the bloom source (only the Sun glows).
+static const char *FSHADER = R"(
+#version 410 core
+in vec2 vUV; 
+uniform sampler2D tex; 
+uniform float uEmissive; // share of the colour that glows
+layout(location=0) out vec4 FragColor;
+layout(location=1) out vec4 Emissive;
+void main(){ 
+  vec3 c = texture(tex, vUV).rgb;
+  FragColor = vec4(c, 1.0);
+  Emissive = vec4(c * uEmissive, 1.0);
+}
+)";
+
+// Lit shaders for planets (with lighting)
+static const char *LIT_VSHADER = R"(
+#version 410 core
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aUV;
+layout(location=2) in vec3 aNrm;
+
+uniform mat4 MVP;
+uniform mat4 MV;
+uniform mat3 NormalM;
+
+out vec2 vUV;
+out vec3 vNormal;
+out vec3 vViewPos;
+
+void main() {
+    vUV = aUV;
+    vNormal = NormalM * aNrm;
+    vViewPos = vec3(MV * vec4(aPos, 1.0));
+    gl_Position = MVP * vec4(aPos, 1.0);
+}
+)";
+
+static const char *LIT_FSHADER = R"(
+#version 410 core
+in vec2 vUV;
+in vec3 vNormal;
+in vec3 vViewPos;
+
+uniform sampler2D tex;
+uniform vec3 lightPosVS;
+uniform vec3 lightColor;
+
+layout(location=0) out vec4 FragColor;
+layout(location=1) out vec4 Emissive; // planets block the Sun's glow
+
+void main() {
+    vec3 N = normalize(-vNormal);  // Flip normal to point outward
+    vec3 L = normalize(lightPosVS - vViewPos);
+    vec3 V = normalize(-vViewPos);
+    vec3 R = reflect(-L, N);
+    
+    // Lighting calculations
+    float diff = max(dot(N, L), 0.0);
+    float spec = pow(max(dot(R, V), 0.0), 32.0);
+    
+    // Add hemisphere lighting for better fill (simulates sky light)
+    vec3 skyDir = vec3(0, 1, 0); // up direction in view space
+    float hemisphere = 0.25 * max(dot(N, skyDir), 0.0);
+    
+    vec3 albedo = texture(tex, vUV).rgb;
+    vec3 ambient = 0.15 * albedo;
+    vec3 diffuse = diff * albedo * lightColor;
+    vec3 specular = spec * 0.3 * lightColor;
+    vec3 fill = hemisphere * albedo * lightColor * 0.4; // subtle fill light
+    
+    vec3 color = ambient + diffuse + specular + fill;
+    FragColor = vec4(color, 1.0);
+    Emissive = vec4(0.0, 0.0, 0.0, 1.0);
+}
+)";
+
+// Background shaders (for AR camera feed)
+static const char *BG_VSHADER = R"(
+#version 410 core
+layout(location=0) in vec2 aPos;
+layout(location=1) in vec2 aUV;
+out vec2 vUV;
+void main(){ vUV=aUV; gl_Position=vec4(aPos,0.0,1.0); }
+)";
+
+static const char *BG_FSHADER = R"(
+#version 410 core
+in vec2 vUV; uniform sampler2D tex; out vec4 FragColor;
+void main(){ FragColor = texture(tex, vUV); }
+)";
+
+// Upscale composite of the offscreen 3-D layer (premultiplied alpha).
+// Only the [0, uUVScale] corner of the target holds this frame's pixels.
+static const char *COMPOSITE_VSHADER = R"(
+#version 410 core
+layout(location=0) in vec2 aPos;
+out vec2 vUV;
+void main(){ vUV = aPos * 0.5 + 0.5; gl_Position = vec4(aPos, 0.0, 1.0); }
+)";
+
+static const char *COMPOSITE_FSHADER = R"(
+#version 410 core
+in vec2 vUV;
+uniform sampler2D tex;
+uniform vec2 uUVScale;    // rendered fraction of the target
+uniform vec2 uTexel;      // 1 / target size
+uniform float uSharpness; // 0 = bilinear
+uniform float uFade;      // marker fade, the only alpha the system gets
+uniform sampler2D uBloom; // unit 1, blurred emissive
+uniform vec2 uBloomUVScale, uBloomTexel;
+uniform float uBloomStrength;
+out vec4 FragColor;
+
+vec4 at(vec2 uv) { return texture(tex, clamp(uv, 0.5 * uTexel, uUVScale - 0.5 * uTexel)); }
+
+void main(){
+  vec2 uv = vUV * uUVScale;
+  vec4 c = at(uv);
+  vec4 n = at(uv + vec2(0.0, uTexel.y));
+  vec4 s = at(uv - vec2(0.0, uTexel.y));
+  vec4 e = at(uv + vec2(uTexel.x, 0.0));
+  vec4 w = at(uv - vec2(uTexel.x, 0.0));
+  // Unsharp mask on the source grid restores edges lost to upscaling
+  vec4 r = c + uSharpness * (4.0 * c - n - s - e - w) * 0.25;
+  r = clamp(r, 0.0, 1.0);
+  r.rgb = min(r.rgb, vec3(r.a)); // stay a valid premultiplied colour
+  vec3 glow = texture(uBloom, min(vUV * uBloomUVScale, uBloomUVScale - 0.5 * uBloomTexel)).rgb;
+  FragColor = vec4(r.rgb + uBloomStrength * glow, r.a) * uFade; // glow adds, even over the camera
+}
+)";
+
+// Orbit trails: positions pulled from the ring TBO (frame-major: slot * uBodies + body).
+// Vertex k of body b's strip is its position k frames ago; draws start at b * uLen.
+static const char *TRAIL_VSHADER = R"(
+#version 410 core
+uniform samplerBuffer uRing;
+uniform int uBodies, uLen, uHead;
+uniform mat4 VP;
+uniform int uEye; // -1 mono, 0/1 = left/right half of a side-by-side target
+out float vFade;
+out float gl_ClipDistance[1];
+void main(){
+  int body = gl_VertexID / uLen;
+  int age = gl_VertexID - body * uLen;
+  int slot = (uHead - age + uLen) % uLen;
+  vec3 p = texelFetch(uRing, slot * uBodies + body).xyz;
+  vFade = 1.0 - float(age) / float(uLen);
+  vec4 c = VP * vec4(p, 1.0);
+  gl_ClipDistance[0] = 1.0;
+  if (uEye >= 0) {
+    c.x = 0.5 * c.x + (uEye == 0 ? -0.5 : 0.5) * c.w;
+    gl_ClipDistance[0] = uEye == 0 ? -c.x : c.x;
+  }
+  gl_Position = c;
+}
+)";
+
+static const char *TRAIL_FSHADER = R"(
+#version 410 core
+in float vFade;
+uniform vec3 uColor;
+layout(location=0) out vec4 FragColor;
+layout(location=1) out vec4 Emissive;
+void main(){
+  FragColor = vec4(uColor, vFade * vFade);
+  Emissive = vec4(0.0); // zero alpha: leaves the glow under the line as it was
+}
+)";
+
+// Bloom: 4-tap box downsample of the emissive attachment, then a separable
+// 9-tap Gaussian (5 bilinear fetches) per direction
+static const char *BLOOM_DOWN_FSHADER = R"(
+#version 410 core
+in vec2 vUV;
+uniform sampler2D tex;
+uniform vec2 uUVScale, uTexel; // source sub-rect and texel
+out vec4 FragColor;
+vec3 at(vec2 uv) { return texture(tex, clamp(uv, 0.5 * uTexel, uUVScale - 0.5 * uTexel)).rgb; }
+void main(){
+  vec2 uv = vUV * uUVScale;
+  vec3 c = at(uv + vec2(-uTexel.x, -uTexel.y)) + at(uv + vec2(uTexel.x, -uTexel.y)) +
+           at(uv + vec2(-uTexel.x, uTexel.y)) + at(uv + vec2(uTexel.x, uTexel.y));
+  FragColor = vec4(0.25 * c, 1.0);
+}
+)";
+
+static const char *BLOOM_BLUR_FSHADER = R"(
+#version 410 core
+in vec2 vUV;
+uniform sampler2D tex;
+uniform vec2 uUVScale, uTexel;
+uniform vec2 uDir; // one step along the blur axis, in UV
+out vec4 FragColor;
+vec3 at(vec2 uv) { return texture(tex, clamp(uv, 0.5 * uTexel, uUVScale - 0.5 * uTexel)).rgb; }
+void main(){
+  vec2 uv = vUV * uUVScale;
+  vec3 c = 0.2270270270 * at(uv);
+  c += 0.3162162162 * (at(uv + 1.3846153846 * uDir) + at(uv - 1.3846153846 * uDir));
+  c += 0.0702702703 * (at(uv + 3.2307692308 * uDir) + at(uv - 3.2307692308 * uDir));
+  FragColor = vec4(c, 1.0);
+}
+)";
+
+// Virtual-textured planets (VirtualTextures). `tex` is the body's page table:
+// per tile (cache x, cache y, resident level, source id + 1). TILE / BORDER
+// match vt_format.hpp. The level is rounded, not blended: no trilinear
+// across tiles.
+static const char *LIT_VT_FSHADER = R"(
+#version 410 core
+in vec2 vUV;
+in vec3 vNormal;
+in vec3 vViewPos;
+
+uniform sampler2D tex;      // page table
+uniform sampler2D uVTCache; // physical tile cache
+uniform vec3 lightPosVS;
+uniform vec3 lightColor;
+
+layout(location=0) out vec4 FragColor;
+layout(location=1) out vec4 Emissive;
+
+const float TILE = 128.0, BORDER = 4.0, PHYS = 136.0;
+
+vec3 vtSample(vec2 uv) {
+    vec2 tiles0 = vec2(textureSize(tex, 0));
+    float maxLevel = floor(log2(min(tiles0.x, tiles0.y)));
+    vec2 t = uv * tiles0 * TILE;
+    float lod = 0.5 * log2(max(dot(dFdx(t), dFdx(t)), dot(dFdy(t), dFdy(t))));
+    float level = clamp(floor(lod + 0.5), 0.0, maxLevel);
+
+    vec2 p = vec2(fract(uv.x), clamp(uv.y, 0.0, 0.99999));
+    vec2 tiles = max(floor(tiles0 / exp2(level)), vec2(1.0));
+    vec4 e = floor(texelFetch(tex, ivec2(p * tiles), int(level)) * 255.0 + 0.5);
+
+    // e.b: the level actually resident (this one or an ancestor)
+    vec2 inTile = fract(p * max(floor(tiles0 / exp2(e.b)), vec2(1.0)));
+    vec2 px = e.rg * PHYS + BORDER + inTile * TILE;
+    return textureLod(uVTCache, px / vec2(textureSize(uVTCache, 0)), 0.0).rgb;
+}
+
+void main() {
+    vec3 N = normalize(-vNormal);
+    vec3 L = normalize(lightPosVS - vViewPos);
+    vec3 V = normalize(-vViewPos);
+    vec3 R = reflect(-L, N);
+
+    float diff = max(dot(N, L), 0.0);
+    float spec = pow(max(dot(R, V), 0.0), 32.0);
+    float hemisphere = 0.25 * max(dot(N, vec3(0, 1, 0)), 0.0);
+
+    vec3 albedo = vtSample(vUV);
+    vec3 color = 0.15 * albedo + diff * albedo * lightColor + spec * 0.3 * lightColor +
+                 hemisphere * albedo * lightColor * 0.4;
+    FragColor = vec4(color, 1.0);
+    Emissive = vec4(0.0, 0.0, 0.0, 1.0);
+}
+)";
+
+// Feedback for VirtualTextures: which tile at which level each pixel wants.
+// Paired with LIT_VSHADER; drawn into a reduced target, hence uLodBias.
+static const char *VT_FEEDBACK_FSHADER = R"(
+#version 410 core
+in vec2 vUV;
+uniform sampler2D tex;   // page table
+uniform float uLodBias;  // -log2(downscale)
+out vec4 FragColor;      // (tile x, tile y, level, source id + 1) / 255
+
+const float TILE = 128.0;
+
+void main(){
+  vec2 tiles0 = vec2(textureSize(tex, 0));
+  float maxLevel = floor(log2(min(tiles0.x, tiles0.y)));
+  vec2 t = vUV * tiles0 * TILE;
+  float lod = 0.5 * log2(max(dot(dFdx(t), dFdx(t)), dot(dFdy(t), dFdy(t)))) + uLodBias;
+  float level = clamp(floor(lod + 0.5), 0.0, maxLevel);
+
+  vec2 p = vec2(fract(vUV.x), clamp(vUV.y, 0.0, 0.99999));
+  vec2 tile = floor(p * max(floor(tiles0 / exp2(level)), vec2(1.0)));
+  float id = texelFetch(tex, ivec2(0), int(maxLevel)).a; // every entry carries it
+  FragColor = vec4(tile / 255.0, level / 255.0, id);
+}
+)";
+
+// ---- Single-pass stereo variants ----
+// Drawn with 2 instances; gl_InstanceID picks the eye. Each eye is squeezed
+// into its half of clip space and a user clip plane cuts it at the seam
+// (GL 4.1 cannot select a viewport from the vertex shader). Lighting
+// inputs stay in centre-eye view space, so the fragment shaders are shared.
+static const char *STEREO_VSHADER = R"(
+#version 410 core
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aUV;
+uniform mat4 MV;
+uniform mat4 uEyeProj[2];
+out vec2 vUV;
+out float gl_ClipDistance[1];
+void main(){
+  int eye = gl_InstanceID;
+  vec4 c = uEyeProj[eye] * MV * vec4(aPos, 1.0);
+  c.x = 0.5 * c.x + (eye == 0 ? -0.5 : 0.5) * c.w;
+  gl_ClipDistance[0] = eye == 0 ? -c.x : c.x;
+  vUV = aUV;
+  gl_Position = c;
+}
+)";
+
+static const char *STEREO_LIT_VSHADER = R"(
+#version 410 core
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aUV;
+layout(location=2) in vec3 aNrm;
+
+uniform mat4 MV;
+uniform mat3 NormalM;
+uniform mat4 uEyeProj[2];
+
+out vec2 vUV;
+out vec3 vNormal;
+out vec3 vViewPos;
+out float gl_ClipDistance[1];
+
+void main() {
+    int eye = gl_InstanceID;
+    vec4 viewPos = MV * vec4(aPos, 1.0);
+    vec4 c = uEyeProj[eye] * viewPos;
+    c.x = 0.5 * c.x + (eye == 0 ? -0.5 : 0.5) * c.w;
+    gl_ClipDistance[0] = eye == 0 ? -c.x : c.x;
+
+    vUV = aUV;
+    vNormal = NormalM * aNrm;
+    vViewPos = viewPos.xyz;
+    gl_Position = c;
+}
+)";
+
+static const char *STEREO_BG_VSHADER = R"(
+#version 410 core
+layout(location=0) in vec2 aPos;
+layout(location=1) in vec2 aUV;
+out vec2 vUV;
+out float gl_ClipDistance[1];
+void main(){
+  float side = gl_InstanceID == 0 ? -0.5 : 0.5;
+  gl_ClipDistance[0] = 1.0; // halves never overlap
+  vUV = aUV;
+  gl_Position = vec4(0.5 * aPos.x + side, aPos.y, 0.0, 1.0);
+}
+)";
@@ -0,0 +1,148 @@
+#pragma once
+// Shared-memory frame ring: layout shared by the publisher (FramePublisher)
+// and a header-only subscriber for other local processes.
+//
+// One POSIX shm object holds a RingHeader followed by `slots` fixed-size
+// slots, each a SlotHeader plus one camera frame. Slots are written
+// round-robin under a per-slot seqlock: the writer makes `seq` odd, writes,
+// then makes it even again. It never waits for readers; a reader that was
+// overtaken sees `seq` change and drops or retries that read.
+//
+//   FrameSubscriber sub;
+//   if (sub.open("/solar-ar"))
+//     sub.readLatest([](const shm::SlotHeader &h, const unsigned char *px) { ... });
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shm
+{
+  constexpr std::uint32_t kMagic = 0x52415353; // "SSAR"
+  constexpr std::uint32_t kVersion = 1;
+  constexpr std::size_t kAlign = 64;           // cache line
+
+  enum PixelFormat : std::uint32_t
+  {
+    RGB8 = 1,
+  };
+
+  struct RingHeader
+  {
+    std::uint32_t magic, version;
+    std::uint32_t slots;
+    std::uint32_t width, height, stride; // stride in bytes per row
+    std::uint32_t format;                // PixelFormat
+    std::uint32_t pad_;
+    std::uint64_t slotBytes;             // SlotHeader + pixels, aligned
+    std::uint64_t pixelOffset;           // from slot start
+    std::atomic<std::uint64_t> latest;   // frame number of the newest complete slot (0 = none)
+  };
+
+  struct SlotHeader
+  {
+    std::atomic<std::uint64_t> seq; // seqlock: odd while being written
+    std::uint64_t frame;            // publisher frame number, 1-based
+    double timestamp;               // seconds, CLOCK_MONOTONIC
+    float view[16];                 // ARTracker::view(), column-major
+    float proj[16];                 // ARTracker::proj(), column-major
+    std::int32_t markerVisible;
+    std::int32_t pad_;
+  };
+
+  constexpr std::size_t align(std::size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+  constexpr std::size_t headerBytes() { return align(sizeof(RingHeader)); }
+
+  inline std::size_t totalBytes(std::uint32_t slots, std::size_t slotBytes)
+  {
+    return headerBytes() + std::size_t(slots) * slotBytes;
+  }
+
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "seqlock needs lock-free 64-bit atomics");
+} // namespace shm
+
+// Read-only view of a ring published by another process.
+class FrameSubscriber
+{
+public:
+  FrameSubscriber() = default;
+  FrameSubscriber(const FrameSubscriber &) = delete;
+  FrameSubscriber &operator=(const FrameSubscriber &) = delete;
+  ~FrameSubscriber() { close(); }
+
+  bool open(const char *name)
+  {
+    close();
+    int fd = ::shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+      return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || std::size_t(st.st_size) < shm::headerBytes())
+    {
+      ::close(fd);
+      return false;
+    }
+    void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return false;
+    base_ = static_cast<const unsigned char *>(p);
+    size_ = st.st_size;
+    const shm::RingHeader &h = header();
+    if (h.magic != shm::kMagic || h.version != shm::kVersion ||
+        shm::totalBytes(h.slots, h.slotBytes) > size_)
+    {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close()
+  {
+    if (base_)
+      ::munmap(const_cast<unsigned char *>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+  }
+
+  bool isOpen() const { return base_ != nullptr; }
+  const shm::RingHeader &header() const { return *reinterpret_cast<const shm::RingHeader *>(base_); }
+  std::uint64_t latest() const { return header().latest.load(std::memory_order_acquire); }
+
+  // Hands the newest slot to fn(const SlotHeader&, const unsigned char *pixels)
+  // in place (no copy), then checks the writer did not touch it meanwhile.
+  // Returns false if there is no frame yet or the read was torn; anything fn
+  // produced from a torn read must be discarded.
+  template <class Fn>
+  bool readLatest(Fn &&fn) const
+  {
+    std::uint64_t n = latest();
+    return n ? read(n, fn) : false;
+  }
+
+  // Same for a given frame number; fails once the ring has moved past it.
+  template <class Fn>
+  bool read(std::uint64_t frame, Fn &&fn) const
+  {
+    const shm::RingHeader &h = header();
+    const unsigned char *slot = base_ + shm::headerBytes() + ((frame - 1) % h.slots) * h.slotBytes;
+    const auto &sh = *reinterpret_cast<const shm::SlotHeader *>(slot);
+
+    std::uint64_t s0 = sh.seq.load(std::memory_order_acquire);
+    if ((s0 & 1) || sh.frame != frame)
+      return false;
+    fn(sh, slot + h.pixelOffset);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sh.seq.load(std::memory_order_relaxed) == s0;
+  }
+
+private:
+  const unsigned char *base_{nullptr};
+  std::size_t size_{0};
+};
@@ -0,0 +1,195 @@
+#include "simulation.hpp"
+#include "scene.hpp"
+#include "object.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+
+Simulation::Simulation(Scene &scene, double hz) : scene_(scene), dt_(1.0 / hz) {}
+
+double Simulation::wallTime()
+{
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Simulation::start()
+{
+  if (run_)
+    return;
+
+  // Seed every buffer with the t = 0 state so sample() is valid at once
+  scene_.update(0.0f, 0.0f);
+  scene_.snapshot(last_);
+  lastWall_ = wallTime();
+  for (Snapshot &s : buf_)
+  {
+    s.t0 = lastWall_ - dt_;
+    s.t1 = lastWall_;
+    s.prev = last_;
+    s.cur = last_;
+    s.orbiting.clear();
+    for (const Object *o : scene_.objects())
+      s.orbiting.push_back(o->orbitRadius > 0.0f);
+  }
+
+  run_ = true;
+  thread_ = std::thread(&Simulation::loop, this);
+  LOG_INF("Simulation thread started at %.0f Hz", rate());
+}
+
+void Simulation::stop()
+{
+  if (!run_)
+    return;
+  run_ = false;
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void Simulation::post(SimCommand cmd)
+{
+  std::lock_guard<std::mutex> lk(cmdMutex_);
+  cmds_.push_back(std::move(cmd));
+}
+
+void Simulation::loop()
+{
+  using clock = std::chrono::steady_clock;
+  const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt_));
+  auto next = clock::now();
+
+  while (run_)
+  {
+    next += period;
+    double t0 = wallTime();
+    tick(t0);
+    double cost = wallTime() - t0;
+
+    {
+      std::lock_guard<std::mutex> lk(statsMutex_);
+      ++stats_.ticks;
+      stats_.simTime = simTime_;
+      costAcc_ += cost;
+      ++costN_;
+      costWindow_ += dt_;
+      if (costWindow_ >= 1.0)
+      {
+        stats_.tickMs = float(1000.0 * costAcc_ / costN_);
+        costAcc_ = costWindow_ = 0.0;
+        costN_ = 0;
+      }
+    }
+
+    auto now = clock::now();
+    if (now > next + period)
+    {
+      // Fell behind (debugger, suspend): drop the backlog rather than catch up in a burst
+      next = now;
+      std::lock_guard<std::mutex> lk(statsMutex_);
+      ++stats_.late;
+    }
+    std::this_thread::sleep_until(next);
+  }
+}
+
+void Simulation::tick(double wallNow)
+{
+  applyCommands();
+  float step = paused() ? 0.0f : float(dt_) * timeScale();
+  simTime_ += step;
+  scene_.update(step, float(simTime_));
+  publish(wallNow);
+}
+
+void Simulation::applyCommands()
+{
+  {
+    std::lock_guard<std::mutex> lk(cmdMutex_);
+    if (cmds_.empty())
+      return;
+    applying_.swap(cmds_);
+  }
+
+  std::lock_guard<std::mutex> lk(paramMutex_);
+  const auto &objs = scene_.objects();
+  for (const SimCommand &c : applying_)
+  {
+    switch (c.op)
+    {
+    case SimCommand::Op::TimeScale:
+      timeScale_ = c.value;
+      continue;
+    case SimCommand::Op::Pause:
+      paused_ = c.value != 0.0f;
+      continue;
+    default:
+      break;
+    }
+    for (int b : c.bodies)
+    {
+      if (b < 0 || b >= int(objs.size()))
+        continue;
+      Object &o = *objs[b];
+      switch (c.op)
+      {
+      case SimCommand::Op::Spin:
+        o.spinSpeed = c.value;
+        break;
+      case SimCommand::Op::OrbitSpeed:
+        o.orbitSpeed = c.value;
+        break;
+      case SimCommand::Op::OrbitRadius:
+        o.orbitRadius = c.value;
+        o.markDirty();
+        break;
+      case SimCommand::Op::OrbitAxis:
+        o.orbitAxis = c.axis;
+        o.markDirty();
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  applying_.clear();
+}
+
+void Simulation::publish(double wallNow)
+{
+  Snapshot &s = buf_[back_];
+  s.t0 = lastWall_;
+  s.t1 = wallNow;
+  s.prev = last_; // same size every tick: no reallocation
+  scene_.snapshot(s.cur);
+  last_ = s.cur;
+  const auto &objs = scene_.objects();
+  s.orbiting.resize(objs.size());
+  for (std::size_t i = 0; i < objs.size(); ++i)
+    s.orbiting[i] = objs[i]->orbitRadius > 0.0f;
+  lastWall_ = wallNow;
+
+  back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & ~kFresh;
+}
+
+const std::vector<glm::mat4> &Simulation::sample()
+{
+  if (middle_.load(std::memory_order_relaxed) & kFresh)
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~kFresh;
+  const Snapshot &s = buf_[front_];
+
+  // Render one tick in the past so "now - dt" normally lies inside [t0, t1]
+  double span = s.t1 - s.t0;
+  float a = span > 0.0 ? float(std::clamp((wallTime() - dt_ - s.t0) / span, 0.0, 1.0)) : 1.0f;
+
+  out_.resize(s.cur.size());
+  for (std::size_t i = 0; i < out_.size(); ++i)
+    out_[i] = s.prev[i] + (s.cur[i] - s.prev[i]) * a; // ticks are small: linear blend is enough
+  return out_;
+}
+
+SimStats Simulation::stats() const
+{
+  std::lock_guard<std::mutex> lk(statsMutex_);
+  return stats_;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Scene;
+
+// Edit sent from the UI to the simulation thread
+struct SimCommand
+{
+  enum class Op : std::uint8_t
+  {
+    Spin,        // value: rad/s
+    OrbitSpeed,  // value: rad/s
+    OrbitRadius, // value
+    OrbitAxis,   // axis
+    TimeScale,   // value: simulated seconds per second
+    Pause,       // value != 0
+  };
+  Op op;
+  float value{0};
+  glm::vec3 axis{0};
+  std::vector<int> bodies; // scene indices for body ops
+};
+
+struct SimStats
+{
+  std::uint64_t ticks{0};
+  std::uint64_t late{0};   // ticks that started more than one period behind
+  float tickMs{0};         // mean cost of the last second
+  double simTime{0};       // simulated seconds
+};
+
+// Runs Scene::update on its own thread at a fixed rate and publishes body
+// transforms through a lock-free triple buffer. Each snapshot carries the
+// last two ticks, so the renderer interpolates between them one tick in the
+// past without ever waiting on the simulation. UI edits arrive as commands
+// and are applied between ticks.
+class Simulation
+{
+public:
+  explicit Simulation(Scene &scene, double hz = 120.0);
+  ~Simulation() { stop(); }
+  Simulation(const Simulation &) = delete;
+  Simulation &operator=(const Simulation &) = delete;
+
+  void start();
+  void stop();
+
+  void post(SimCommand cmd);
+
+  // Render thread: models interpolated for "now", in scene order
+  const std::vector<glm::mat4> &sample();
+  const std::vector<std::uint8_t> &orbiting() const { return buf_[front_].orbiting; }
+
+  // Hold while reading body parameters (speeds, radii, axes) off the
+  // simulation thread; commands are applied under the same lock
+  std::unique_lock<std::mutex> lockParams() { return std::unique_lock<std::mutex>(paramMutex_); }
+
+  SimStats stats() const;
+  double rate() const { return 1.0 / dt_; }
+  float timeScale() const { return timeScale_.load(std::memory_order_relaxed); }
+  bool paused() const { return paused_.load(std::memory_order_relaxed); }
+
+private:
+  struct Snapshot
+  {
+    double t0{0}, t1{0}; // wall time of the two ticks (steady clock, s)
+    std::vector<glm::mat4> prev, cur;
+    std::vector<std::uint8_t> orbiting;
+  };
+
+  void loop();
+  void tick(double wallNow);
+  void applyCommands();
+  void publish(double wallNow);
+  static double wallTime();
+
+  Scene &scene_;
+  const double dt_;
+
+  // Triple buffer: back_ is the simulation's, front_ the renderer's,
+  // middle_ the hand-over slot (kFresh set when it holds an unread tick)
+  static constexpr int kFresh = 4;
+  Snapshot buf_[3];
+  int back_{0}, front_{1};
+  std::atomic<int> middle_{2};
+
+  std::thread thread_;
+  std::atomic<bool> run_{false};
+
+  std::mutex cmdMutex_, paramMutex_;
+  std::vector<SimCommand> cmds_, applying_;
+
+  // Simulation thread state
+  std::vector<glm::mat4> last_;
+  double lastWall_{0}, simTime_{0};
+  std::atomic<float> timeScale_{1.0f};
+  std::atomic<bool> paused_{false};
+
+  mutable std::mutex statsMutex_;
+  SimStats stats_;
+  double costAcc_{0};
+  int costN_{0};
+  double costWindow_{0};
+
+  std::vector<glm::mat4> out_; // render thread
+};
@@ -0,0 +1,124 @@
+#include "solar_system.hpp"
+#include "shader.hpp"
+#include "virtual_texture.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include "logger.hpp"
+
+glm::mat4 SystemSettings::transform() const
+{
+  // Move entire system above marker along its +Z axis (away from tablet surface)
+  glm::mat4 h = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, +hover)); // POSITIVE = above tablet
+  return glm::scale(h, glm::vec3(scale));
+}
+
+glm::vec3 SystemSettings::lightColor() const
+{
+  return glm::vec3(1.0f, lightWarmth, 0.8f) * lightIntensity;
+}
+
+SolarSystem::SolarSystem(AssetRegistry &a, int sphereDetail)
+    : assets(a),
+      sun{a.sphere(sphereDetail, sphereDetail), a.loadTexture("assets/sun.jpg")},
+      earth{a.sphere(sphereDetail, sphereDetail), a.loadTexture("assets/earth.jpg")},
+      moon{a.sphere(sphereDetail, sphereDetail), a.loadTexture("assets/moon.jpg")}
+{
+  sun.name = "Sun";
+  earth.name = "Earth";
+  moon.name = "Moon";
+
+  // Visible solar system scales (all in marker units)
+  sun.localScale = glm::vec3(0.18f);
+  sun.spinSpeed = glm::radians(15.f);
+
+  earth.localScale = glm::vec3(0.08f);
+  earth.spinSpeed = glm::radians(90.f);
+  earth.orbitRadius = 0.4f;
+  earth.orbitSpeed = glm::radians(24.f);
+  earth.orbitAxis = glm::normalize(glm::vec3(0.1f, 0, 1));
+
+  moon.localScale = glm::vec3(0.02f);
+  moon.spinSpeed = glm::radians(60.f);
+  moon.orbitRadius = 0.12f;
+  moon.orbitSpeed = glm::radians(75.f);
+  moon.orbitTarget = &earth;
+  moon.orbitAxis = glm::normalize(glm::vec3(0.1f, 0, 1));
+
+  scene.add(&sun); // parents first so children read updated frames
+  scene.add(&earth);
+  scene.add(&moon);
+  // Tilt the orbital plane 20 degrees so Earth doesn't hide behind the Sun
+  scene.setRoot(glm::rotate(glm::mat4(1.0f), glm::radians(-20.f), glm::vec3(1, 0, 0)));
+
+  LOG_INF("Solar system created - Sun:%.3f Earth:%.3f Moon:%.3f", 0.18f, 0.08f, 0.02f);
+}
+
+SolarSystem::~SolarSystem()
+{
+  for (Object *o : {&sun, &earth, &moon})
+  {
+    assets.release(o->mesh);
+    assets.release(o->tex);
+  }
+}
+
+void SolarSystem::evaluate(float t)
+{
+  for (Object *o : {&sun, &earth, &moon})
+  {
+    o->spinAngle = o->orbitAngle = 0.0f;
+    o->markDirty();
+  }
+  scene.update(t, t);
+}
+
+void SolarSystem::useVirtualTextures(VirtualTextures &vt)
+{
+  const std::pair<Body, const char *> surfaces[] = {{Earth, "assets/earth.vt"}, {Moon, "assets/moon.vt"}};
+  for (const auto &[b, path] : surfaces)
+  {
+    int id = vt.open(path);
+    surfaceVT[b] = id >= 0 ? vt.pageTable(id) : 0;
+  }
+}
+
+void SolarSystem::submit(RenderQueue &q, const Shader &lit, const Shader &unlit,
+                         const glm::mat4 &view, const SystemSettings &s,
+                         const std::vector<glm::mat4> &models, const Shader *litVT) const
+{
+  glm::mat4 transform = s.transform();
+  glm::vec3 sunPosVS = glm::vec3(view * transform * models[Sun][3]);
+  glm::vec3 light = s.lightColor();
+
+  // Per-frame uniforms go straight to the programs; the queue binds them later
+  for (const Shader *sh : {&lit, litVT})
+    if (sh)
+    {
+      glProgramUniform3fv(sh->id(), sh->uniform("lightPosVS"), 1, &sunPosVS[0]);
+      glProgramUniform3fv(sh->id(), sh->uniform("lightColor"), 1, &light[0]);
+    }
+  glProgramUniform1f(unlit.id(), unlit.uniform("uEmissive"), 1.0f);
+
+  // All opaque: the marker fade is applied once when the layer is composited
+  for (Body b : {Earth, Moon})
+  {
+    const Object &o = b == Earth ? earth : moon;
+    const Mesh *m = assets.get(o.mesh);
+    if (litVT && surfaceVT[b] && m)
+      q.submit(RenderPass::Opaque, BlendMode::None, *litVT, surfaceVT[b], *m, transform * models[b]);
+    else
+      o.submit(q, assets, lit, RenderPass::Opaque, BlendMode::None, transform * models[b]);
+  }
+  sun.submit(q, assets, unlit, RenderPass::Opaque, BlendMode::None, transform * models[Sun]);
+}
+
+void SolarSystem::submitFeedback(RenderQueue &q, const Shader &feedback, const SystemSettings &s,
+                                 const std::vector<glm::mat4> &models) const
+{
+  glm::mat4 transform = s.transform();
+  for (Body b : {Earth, Moon})
+  {
+    const Mesh *m = assets.get((b == Earth ? earth : moon).mesh);
+    if (surfaceVT[b] && m)
+      q.submit(RenderPass::Opaque, BlendMode::None, feedback, surfaceVT[b], *m, transform * models[b]);
+  }
+}
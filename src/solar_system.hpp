@@ -0,0 +1,56 @@
+#pragma once
+#include "object.hpp"
+#include "scene.hpp"
+#include "render_queue.hpp"
+#include <glm/glm.hpp>
+
+class Shader;
+class VirtualTextures;
+
+// User-tunable system placement and lighting (ImGui panel)
+struct SystemSettings
+{
+  float hover = 0.06f;          // height above marker (closer to tablet for demo)
+  float scale = 0.3f;           // smaller system by default for demo
+  float lightIntensity = 0.8f;  // sun light intensity (reduced from 1.0 for realism)
+  float lightWarmth = 0.95f;    // light warmth (yellow vs white)
+
+  glm::mat4 transform() const;  // hover * scale, marker space
+  glm::vec3 lightColor() const; // warm sunlight
+};
+
+// Sun/Earth/Moon with the demo defaults, shared by the live app and the
+// offline renderer. Holds one reference on each asset it uses.
+// Not copyable: the Moon points at the Earth.
+struct SolarSystem
+{
+  enum Body { Sun, Earth, Moon }; // scene order
+
+  AssetRegistry &assets;
+  Object sun, earth, moon;
+  Scene scene;
+
+  explicit SolarSystem(AssetRegistry &a, int sphereDetail = 64);
+  ~SolarSystem();
+  SolarSystem(const SolarSystem &) = delete;
+  SolarSystem &operator=(const SolarSystem &) = delete;
+
+  void evaluate(float t); // state at absolute time t (angles from zero)
+
+  // Sets per-frame uniforms and queues the three bodies, opaque, at `models`
+  // (scene order: from Scene::snapshot or Simulation::sample). The unlit
+  // program writes the Sun's glow to colour attachment 1.
+  // With litVT (LIT_VT_FSHADER), bodies that have a virtual texture use it instead.
+  void submit(RenderQueue &q, const Shader &lit, const Shader &unlit, const glm::mat4 &view,
+              const SystemSettings &s, const std::vector<glm::mat4> &models,
+              const Shader *litVT = nullptr) const;
+
+  // Planet surfaces from cooked tile pyramids (assets/<body>.vt), where present.
+  void useVirtualTextures(VirtualTextures &vt);
+  // Queues the virtually textured bodies for the VT feedback pass. The Sun
+  // is not drawn, so bodies behind it still request tiles (harmless).
+  void submitFeedback(RenderQueue &q, const Shader &feedback, const SystemSettings &s,
+                      const std::vector<glm::mat4> &models) const;
+
+  GLuint surfaceVT[3]{}; // page table per body, 0: regular texture
+};
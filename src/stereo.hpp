@@ -0,0 +1,29 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Side-by-side stereo around the tracked (centre) camera.
+// Each eye sits ipd/2 to either side of ARTracker::view()'s origin; the
+// frusta are sheared (off-axis) so both converge at `convergence` metres,
+// where the AR content lines up with the camera image.
+struct StereoRig
+{
+  bool enabled = false;
+  float ipd = 0.063f;        // metres
+  float convergence = 0.40f; // metres, about the marker distance
+
+  // Per-eye "view space -> clip" matrices: P_eye * T(eye offset).
+  // Index 0 is the left eye.
+  void eyeProjections(const glm::mat4 &proj, glm::mat4 out[2]) const
+  {
+    for (int eye = 0; eye < 2; ++eye)
+    {
+      float side = eye == 0 ? -1.0f : 1.0f;     // left eye at -x
+      float half = 0.5f * ipd;
+      glm::mat4 P = proj;
+      P[2][0] -= side * proj[0][0] * half / convergence; // off-axis shift
+      glm::mat4 T = glm::translate(glm::mat4(1.0f), glm::vec3(-side * half, 0, 0));
+      out[eye] = P * T;
+    }
+  }
+};
@@ -6,20 +6,61 @@
 Texture::Texture(const char *path)
 {
   int w, h, n;
-  stbi_set_flip_vertically_on_load(true);
+  // Per-thread flag: offline_render workers load textures concurrently
+  stbi_set_flip_vertically_on_load_thread(1);
   unsigned char *data = stbi_load(path, &w, &h, &n, 0);
   if (!data)
   {
     std::cerr << "texture load failed: " << path << '\n';
     return;
   }
+  upload(data, w, h, n);
+}
 
+Texture Texture::fromMemory(const unsigned char *bytes, int len)
+{
+  Texture t;
+  int w, h, n;
+  stbi_set_flip_vertically_on_load_thread(1);
+  unsigned char *data = stbi_load_from_memory(bytes, len, &w, &h, &n, 0);
+  if (!data)
+  {
+    std::cerr << "texture decode failed: " << stbi_failure_reason() << '\n';
+    return t;
+  }
+  t.upload(data, w, h, n);
+  return t;
+}
+
+Texture &Texture::operator=(Texture &&o) noexcept
+{
+  if (this != &o)
+  {
+    id_ = o.id_;
+    bytes_ = o.bytes_;
+    o.id_ = 0;
+    o.bytes_ = 0;
+  }
+  return *this;
+}
+
+void Texture::upload(unsigned char *data, int w, int h, int n)
+{
   glGenTextures(1, &id_);
   glBindTexture(GL_TEXTURE_2D, id_);
   glTexImage2D(GL_TEXTURE_2D, 0, n == 4 ? GL_RGBA : GL_RGB, w, h, 0,
                n == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, data);
   glGenerateMipmap(GL_TEXTURE_2D);
   stbi_image_free(data);
+  bytes_ = std::size_t(w) * h * 4 * 4 / 3; // drivers pad RGB to RGBA; +1/3 for mips
+}
+
+void Texture::destroy()
+{
+  if (id_)
+    glDeleteTextures(1, &id_);
+  id_ = 0;
+  bytes_ = 0;
 }
 
 void Texture::bind(GLenum unit) const
@@ -1,12 +1,29 @@
 #pragma once
 #include <glad/glad.h>
+#include <cstddef>
 
+// Owns one GL texture name. Move-only; the GL object is freed explicitly with
+// destroy() (AssetRegistry defers that to the render thread).
 class Texture
 {
 public:
+  Texture() = default; // empty (id 0), e.g. CPU-only bodies in benchmarks
   explicit Texture(const char *path);
+  static Texture fromMemory(const unsigned char *bytes, int len); // encoded jpg/png
+
+  Texture(const Texture &) = delete;
+  Texture &operator=(const Texture &) = delete;
+  Texture(Texture &&o) noexcept { *this = static_cast<Texture &&>(o); }
+  Texture &operator=(Texture &&o) noexcept;
+
   void bind(GLenum unit = GL_TEXTURE0) const;
+  void destroy();
+  GLuint id() const { return id_; }
+  std::size_t bytes() const { return bytes_; } // GPU estimate incl. mips
 
 private:
+  void upload(unsigned char *data, int w, int h, int n);
+
   GLuint id_{};
+  std::size_t bytes_{0};
 };
@@ -0,0 +1,143 @@
+#include "trace_writer.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <filesystem>
+#include "logger.hpp"
+
+bool TraceWriter::start(const std::string &dir, const cv::Mat &K, cv::Size size)
+{
+  if (recording())
+    return true;
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  file_ = std::fopen((dir + "/trace.txt").c_str(), "w");
+  if (!file_)
+  {
+    LOG_ERR("Trace: cannot write %s/trace.txt", dir.c_str());
+    return false;
+  }
+  dir_ = dir;
+  std::fprintf(file_, "# AR Solar System session trace (cook/offline_render)\n");
+  std::fprintf(file_, "size %d %d\n", size.width, size.height);
+  std::fprintf(file_, "K %.9g %.9g %.9g %.9g\n", K.at<double>(0, 0), K.at<double>(1, 1),
+               K.at<double>(0, 2), K.at<double>(1, 2));
+
+  pool_.assign(poolSize_, Slot{});
+  free_.clear();
+  free_.reserve(poolSize_);
+  ready_.clear();
+  ready_.reserve(poolSize_);
+  for (int i = 0; i < poolSize_; ++i)
+    free_.push_back(i);
+  images_ = 0;
+  image_ = -1;
+  t0_ = -1;
+  settingsWritten_ = false;
+  frames_ = reused_ = 0;
+  quit_ = false;
+  encoder_ = std::thread(&TraceWriter::encodeLoop, this);
+  LOG_INF("Writing render trace to %s", dir.c_str());
+  return true;
+}
+
+void TraceWriter::stop()
+{
+  if (!recording())
+    return;
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  encoder_.join();
+  std::fclose(file_);
+  file_ = nullptr;
+  LOG_INF("Trace: %llu frames, %d images (%llu reused) in %s", (unsigned long long)frames_, images_,
+          (unsigned long long)reused_, dir_.c_str());
+}
+
+void TraceWriter::record(double t, float alpha, const cv::Mat &camera, const glm::mat4 &view,
+                         double simTime, const std::vector<glm::mat4> *models,
+                         const SystemSettings &s)
+{
+  if (!recording())
+    return;
+  if (!camera.empty())
+  {
+    int slot = -1;
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      if (!free_.empty())
+      {
+        slot = free_.back();
+        free_.pop_back();
+      }
+    }
+    if (slot < 0)
+      ++reused_; // encoder busy: keep pointing at the previous image
+    else
+    {
+      camera.copyTo(pool_[slot].rgb);
+      pool_[slot].index = image_ = images_++;
+      {
+        std::lock_guard<std::mutex> lk(mtx_);
+        ready_.push_back(slot);
+      }
+      cv_.notify_one();
+    }
+  }
+  if (image_ < 0)
+    return; // nothing to draw over yet
+
+  if (!settingsWritten_ || s.hover != written_.hover || s.scale != written_.scale ||
+      s.lightIntensity != written_.lightIntensity || s.lightWarmth != written_.lightWarmth)
+  {
+    std::fprintf(file_, "settings %.9g %.9g %.9g %.9g\n", s.hover, s.scale, s.lightIntensity,
+                 s.lightWarmth);
+    written_ = s;
+    settingsWritten_ = true;
+  }
+
+  if (t0_ < 0)
+    t0_ = t;
+  std::fprintf(file_, "frame %.6f %.4f bg_%06d.jpg", t - t0_, alpha, image_);
+  for (int i = 0; i < 16; ++i)
+    std::fprintf(file_, " %.9g", view[i / 4][i % 4]);
+  std::fputc('\n', file_);
+
+  // Drawn transforms, not parameters: time scale, pause and inspector edits
+  // are already folded in, and accumulated angles cannot be recomputed from t
+  if (models)
+  {
+    std::fprintf(file_, "sim %.6f %zu", simTime, models->size());
+    for (const glm::mat4 &m : *models)
+      for (int i = 0; i < 16; ++i)
+        std::fprintf(file_, " %.9g", m[i / 4][i % 4]);
+    std::fputc('\n', file_);
+  }
+  ++frames_;
+}
+
+void TraceWriter::encodeLoop()
+{
+  cv::Mat bgr;
+  char name[32];
+  for (;;)
+  {
+    int slot;
+    {
+      std::unique_lock<std::mutex> lk(mtx_);
+      cv_.wait(lk, [this] { return quit_ || !ready_.empty(); });
+      if (ready_.empty())
+        return; // quit, queue drained
+      slot = ready_.front();
+      ready_.erase(ready_.begin());
+    }
+    cv::cvtColor(pool_[slot].rgb, bgr, cv::COLOR_RGB2BGR);
+    std::snprintf(name, sizeof(name), "/bg_%06d.jpg", pool_[slot].index);
+    if (!cv::imwrite(dir_ + name, bgr))
+      LOG_ERR("Trace: cannot write %s%s", dir_.c_str(), name);
+    std::lock_guard<std::mutex> lk(mtx_);
+    free_.push_back(slot);
+  }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "solar_system.hpp"
+#include <opencv2/core.hpp>
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Session trace for cook/offline_render (format documented there): one
+// `frame` line per rendered frame with the fade and the view matrix, the
+// simulation time and body transforms actually drawn, the system settings
+// whenever they change, and the camera image the frame was drawn over.
+// Images are JPEG-encoded on a worker thread from a fixed pool of buffers;
+// when the encoder falls behind, a frame reuses the previous image instead
+// of stalling the render thread.
+class TraceWriter
+{
+public:
+  explicit TraceWriter(int poolSize = 4) : poolSize_(poolSize) {}
+  ~TraceWriter() { stop(); }
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  // Creates dir and writes dir/trace.txt; K and size are the camera's
+  bool start(const std::string &dir, const cv::Mat &K, cv::Size size);
+  void stop(); // flushes queued images
+  bool recording() const { return file_ != nullptr; }
+  const std::string &dir() const { return dir_; }
+
+  // Once per rendered frame, t in seconds (any origin; the trace starts at
+  // 0). camera: the RGB image if it changed since the last call, else
+  // empty. alpha: 0 if nothing was drawn. models: the body transforms drawn
+  // (Simulation::sample), null if none.
+  void record(double t, float alpha, const cv::Mat &camera, const glm::mat4 &view,
+              double simTime, const std::vector<glm::mat4> *models, const SystemSettings &s);
+
+  std::uint64_t frames() const { return frames_; }
+  std::uint64_t reused() const { return reused_; } // camera images dropped for a busy encoder
+
+private:
+  void encodeLoop();
+
+  struct Slot
+  {
+    cv::Mat rgb;
+    int index{0};
+  };
+
+  int poolSize_;
+  std::FILE *file_{nullptr};
+  std::string dir_;
+  std::vector<Slot> pool_;
+  std::vector<int> free_, ready_; // slot indices; capacity reserved, never grows
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool quit_{false};
+  std::thread encoder_;
+
+  int images_{0}, image_{-1}; // images queued so far; the one frames refer to
+  double t0_{-1};
+  SystemSettings written_;
+  bool settingsWritten_{false};
+  std::uint64_t frames_{0}, reused_{0};
+};
@@ -0,0 +1,114 @@
+#include "trails.hpp"
+#include "shader.hpp"
+#include <algorithm>
+
+Trails::Trails(int length) : len_(std::max(2, length)) {}
+
+void Trails::setLength(int samples)
+{
+  samples = std::max(2, samples);
+  if (samples == len_)
+    return;
+  len_ = samples;
+  allocate(bodies_);
+}
+
+void Trails::allocate(int bodies)
+{
+  bodies_ = bodies;
+  head_ = -1;
+  filled_ = 0;
+  if (!vao_)
+  {
+    glGenVertexArrays(1, &vao_); // attribute-less draws still need a VAO in core profile
+    glGenBuffers(1, &buf_);
+    glGenTextures(1, &tex_);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, buf_);
+  glBufferData(GL_TEXTURE_BUFFER, std::size_t(bodies_) * len_ * sizeof(glm::vec3), nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindTexture(GL_TEXTURE_BUFFER, tex_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32F, buf_);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  stats_.bufferBytes = std::size_t(bodies_) * len_ * sizeof(glm::vec3);
+}
+
+void Trails::record(const std::vector<glm::mat4> &models, const std::vector<std::uint8_t> &orbiting)
+{
+  if (int(models.size()) != bodies_ || !vao_)
+    allocate(int(models.size()));
+  if (bodies_ == 0)
+    return;
+
+  staging_.resize(bodies_);
+  first_.clear();
+  count_.clear();
+  head_ = (head_ + 1) % len_;
+  filled_ = std::min(filled_ + 1, len_);
+  for (int i = 0; i < bodies_; ++i)
+  {
+    staging_[i] = glm::vec3(models[i][3]);
+    if (orbiting[i]) // the index: only orbiting bodies get a strip
+    {
+      first_.push_back(i * len_);
+      count_.push_back(filled_);
+    }
+  }
+
+  // The whole frame is one contiguous slot at the ring head
+  const std::size_t bytes = std::size_t(bodies_) * sizeof(glm::vec3);
+  glBindBuffer(GL_TEXTURE_BUFFER, buf_);
+  glBufferSubData(GL_TEXTURE_BUFFER, std::size_t(head_) * bytes, bytes, staging_.data());
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  stats_.bodies = int(first_.size());
+  stats_.length = len_;
+  stats_.uploadBytes = bytes;
+  stats_.naiveBytes = first_.size() * std::size_t(filled_) * sizeof(glm::vec3);
+}
+
+void Trails::draw(const Shader &sh, const glm::mat4 &VP, int eye)
+{
+  if (first_.empty() || filled_ < 2)
+    return;
+
+  sh.use();
+  glUniformMatrix4fv(sh.uniform("VP"), 1, GL_FALSE, &VP[0][0]);
+  glUniform1i(sh.uniform("uRing"), 0);
+  glUniform1i(sh.uniform("uBodies"), bodies_);
+  glUniform1i(sh.uniform("uLen"), len_);
+  glUniform1i(sh.uniform("uHead"), head_);
+  glUniform1i(sh.uniform("uEye"), eye);
+  glUniform3fv(sh.uniform("uColor"), 1, &color[0]);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, tex_);
+  glBindVertexArray(vao_);
+
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  if (eye >= 0)
+    glEnable(GL_CLIP_DISTANCE0);
+
+  glMultiDrawArrays(GL_LINE_STRIP, first_.data(), count_.data(), GLsizei(first_.size()));
+
+  glDisable(GL_CLIP_DISTANCE0);
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void Trails::destroy()
+{
+  if (tex_)
+    glDeleteTextures(1, &tex_);
+  if (buf_)
+    glDeleteBuffers(1, &buf_);
+  if (vao_)
+    glDeleteVertexArrays(1, &vao_);
+  tex_ = buf_ = vao_ = 0;
+  bodies_ = 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Shader;
+
+struct TrailStats
+{
+  int bodies{0};                 // bodies drawn (orbiting)
+  int length{0};                 // samples per trail
+  std::size_t uploadBytes{0};    // last frame
+  std::size_t naiveBytes{0};     // re-uploading every strip instead
+  std::size_t bufferBytes{0};    // ring size on the GPU
+};
+
+// Orbit trails for every body of a scene.
+// One ring buffer holds the last `length` positions of all bodies,
+// frame-major, so a frame appends with a single glBufferSubData of N
+// positions. The vertex shader reads it through a buffer texture (no
+// vertex attributes) and fades by age; all trails go out in one
+// glMultiDrawArrays call over per-body (first, count) ranges.
+class Trails
+{
+public:
+  explicit Trails(int length = 240);
+  Trails(const Trails &) = delete;
+  Trails &operator=(const Trails &) = delete;
+
+  void setLength(int samples); // drops the history
+  int length() const { return len_; }
+  void clear() { filled_ = 0; } // forget history (e.g. marker lost)
+
+  // Append every body's position (models from Simulation::sample / Scene::snapshot);
+  // only bodies flagged orbiting get a trail
+  void record(const std::vector<glm::mat4> &models, const std::vector<std::uint8_t> &orbiting);
+  // VP includes the system transform; eye >= 0 draws into that half of a side-by-side target.
+  // Blends into the system layer, which is faded as a whole when composited.
+  void draw(const Shader &sh, const glm::mat4 &VP, int eye = -1);
+  void destroy(); // GL objects; call while the context is current
+
+  const TrailStats &stats() const { return stats_; }
+
+  bool enabled = true;
+  glm::vec3 color{0.55f, 0.75f, 1.0f};
+
+private:
+  void allocate(int bodies);
+
+  GLuint vao_{}, buf_{}, tex_{};
+  int bodies_{0}, len_;
+  int head_{-1}, filled_{0};
+  std::vector<glm::vec3> staging_;
+  std::vector<GLint> first_;
+  std::vector<GLsizei> count_;
+  TrailStats stats_;
+};
@@ -1,13 +1,39 @@
 #pragma once
 #include "object.hpp"
+#include "render_queue.hpp"
+#include "recorder.hpp"
+#include "trace_writer.hpp"
+#include "assets.hpp"
+#include "stereo.hpp"
+#include "dynamic_res.hpp"
+#include "ar_tracker.hpp"
+#include "trails.hpp"
+#include "bloom.hpp"
+#include "virtual_texture.hpp"
+#include "frame_publisher.hpp"
+#include "simulation.hpp"
 #include <imgui.h>
+#include <ctime>
 
-inline void drawOrbitalPanel(Object &sun, Object &earth, Object &moon, float &hover, float &systemScale, 
-                            float &lightIntensity, float &lightWarmth, bool *show = nullptr)
+// System placement and lighting; per-body parameters live in BodyInspector
+inline void drawOrbitalPanel(Simulation &sim, float &hover, float &systemScale, float &lightIntensity,
+                             float &lightWarmth, bool *show = nullptr)
 {
   if (show && !*show)
     return;
   ImGui::Begin("Orbital Control", show);
+
+  // Simulation state lives on its thread: edits go through its command queue
+  ImGui::SeparatorText("Simulation");
+  float speed = sim.timeScale();
+  if (ImGui::SliderFloat("Time scale", &speed, 0.0f, 10.0f, "%.2f×", ImGuiSliderFlags_Logarithmic))
+    sim.post({SimCommand::Op::TimeScale, speed});
+  bool paused = sim.paused();
+  if (ImGui::Checkbox("Paused", &paused))
+    sim.post({SimCommand::Op::Pause, paused ? 1.0f : 0.0f});
+  SimStats ss = sim.stats();
+  ImGui::Text("%.0f Hz, %.3f ms/tick, t = %.1f s, late %llu", sim.rate(), ss.tickMs, ss.simTime,
+              (unsigned long long)ss.late);
   
   ImGui::SeparatorText("System Settings");
   ImGui::SliderFloat("Height above tablet", &hover, 0.02f, 0.20f, "%.2f units");
@@ -27,56 +53,228 @@ inline void drawOrbitalPanel(Object &sun, Object &earth, Object &moon, float &ho
   ImGui::SameLine();
   ImGui::TextDisabled("(yellow/white)");
 
-  static bool showLightDebug = false;
-  ImGui::Checkbox("Show light debug", &showLightDebug);
-  if (showLightDebug) {
-    ImGui::Text("Light follows Sun's exact center position");
-    ImGui::Text("including all transforms and scaling");
+  ImGui::End();
+}
+
+// allocsPerFrame: render-thread heap allocations, -1 when not counted (ALLOC_COUNT=0)
+inline void drawRenderStats(const RenderStats &rs, const AssetRegistry &assets, long long allocsPerFrame,
+                            bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Render Stats", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Text("Draws: %d", rs.draws);
+  ImGui::Text("Programs bound: %d", rs.programBinds);
+  ImGui::Text("Textures bound: %d", rs.textureBinds);
+  ImGui::Text("VAOs bound: %d", rs.vaoBinds);
+  ImGui::Text("State changes: %d", rs.stateChanges);
+  if (allocsPerFrame >= 0)
+    ImGui::Text("Heap allocations: %lld/frame", allocsPerFrame);
+
+  ImGui::SeparatorText("Assets");
+  AssetStats tex = assets.textureStats(), mesh = assets.meshStats();
+  ImGui::Text("Textures: %zu  %.1f MB  (dedup hits %zu, pending %zu)", tex.live,
+              tex.bytes / (1024.0 * 1024.0), tex.hits, tex.pending);
+  ImGui::Text("Meshes:   %zu  %.1f MB  (dedup hits %zu, pending %zu)", mesh.live,
+              mesh.bytes / (1024.0 * 1024.0), mesh.hits, mesh.pending);
+  ImGui::End();
+}
+
+// Start/stop toggle plus queue stats; w/h is the framebuffer size to record
+inline void drawRecorderPanel(FrameRecorder &rec, TraceWriter &trace, int w, int h,
+                              const cv::Mat &K, cv::Size camera, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Recording", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+  bool on = rec.recording();
+  if (ImGui::Checkbox("Record session", &on))
+  {
+    if (on)
+    {
+      char name[64];
+      std::time_t t = std::time(nullptr);
+      std::strftime(name, sizeof(name), "session_%Y%m%d_%H%M%S.mp4", std::localtime(&t));
+      rec.start(name, w, h);
+    }
+    else
+      rec.stop();
   }
 
-  ImGui::SeparatorText("Sun");
-  float sunDeg = glm::degrees(sun.spinSpeed);
-  if (ImGui::SliderFloat("Sun spin (deg/s)", &sunDeg, 0.0f, 60.0f))
-    sun.spinSpeed = glm::radians(sunDeg);
-  
-  ImGui::SeparatorText("Earth");
-  float earthSpinDeg = glm::degrees(earth.spinSpeed);
-  if (ImGui::SliderFloat("Earth spin (deg/s)", &earthSpinDeg, 0.0f, 180.0f))
-    earth.spinSpeed = glm::radians(earthSpinDeg);
-    
-  float earthOrbitDeg = glm::degrees(earth.orbitSpeed);
-  if (ImGui::SliderFloat("Earth orbit (deg/s)", &earthOrbitDeg, 0.0f, 60.0f))
-    earth.orbitSpeed = glm::radians(earthOrbitDeg);
-    
-  ImGui::SliderFloat("Earth radius", &earth.orbitRadius, 0.05f, 4.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
-  
-  // Orbit axis control
-  static const char* axes[] = {"X", "Y", "Z"};
-  int earthAxis = earth.orbitAxis == glm::vec3(1,0,0) ? 0 : 
-                  earth.orbitAxis == glm::vec3(0,1,0) ? 1 : 2;
-  if (ImGui::Combo("Earth orbit axis", &earthAxis, axes, 3)) {
-    earth.orbitAxis = earthAxis == 0 ? glm::vec3(1,0,0) :
-                      earthAxis == 1 ? glm::vec3(0,1,0) : glm::vec3(0,0,1);
+  if (rec.recording())
+  {
+    RecorderStats st = rec.stats();
+    ImGui::TextColored(ImVec4(1, 0.3f, 0.3f, 1), "REC %s", rec.path().c_str());
+    ImGui::Text("Queue: %d / %d", st.queueDepth, st.queueCapacity);
+    ImGui::Text("Captured: %llu  Encoded: %llu", (unsigned long long)st.captured,
+                (unsigned long long)st.encoded);
+    ImGui::Text("Dropped: %llu", (unsigned long long)st.dropped);
   }
-  
-  ImGui::SeparatorText("Moon");
-  float moonSpinDeg = glm::degrees(moon.spinSpeed);
-  if (ImGui::SliderFloat("Moon spin (deg/s)", &moonSpinDeg, 0.0f, 120.0f))
-    moon.spinSpeed = glm::radians(moonSpinDeg);
-    
-  float moonOrbitDeg = glm::degrees(moon.orbitSpeed);
-  if (ImGui::SliderFloat("Moon orbit (deg/s)", &moonOrbitDeg, 0.0f, 150.0f))
-    moon.orbitSpeed = glm::radians(moonOrbitDeg);
-    
-  ImGui::SliderFloat("Moon radius", &moon.orbitRadius, 0.05f, 0.5f, "%.2f", ImGuiSliderFlags_Logarithmic);
-  
-  // Moon orbit axis control
-  int moonAxis = moon.orbitAxis == glm::vec3(1,0,0) ? 0 : 
-                 moon.orbitAxis == glm::vec3(0,1,0) ? 1 : 2;
-  if (ImGui::Combo("Moon orbit axis", &moonAxis, axes, 3)) {
-    moon.orbitAxis = moonAxis == 0 ? glm::vec3(1,0,0) :
-                     moonAxis == 1 ? glm::vec3(0,1,0) : glm::vec3(0,0,1);
+
+  // Pose trace + camera images for cook/offline_render
+  on = trace.recording();
+  if (ImGui::Checkbox("Write render trace", &on))
+  {
+    if (on)
+    {
+      char name[64];
+      std::time_t t = std::time(nullptr);
+      std::strftime(name, sizeof(name), "trace_%Y%m%d_%H%M%S", std::localtime(&t));
+      trace.start(name, K, camera);
+    }
+    else
+      trace.stop();
   }
-  
+  if (trace.recording())
+    ImGui::Text("%s: %llu frames, %llu images reused", trace.dir().c_str(),
+                (unsigned long long)trace.frames(), (unsigned long long)trace.reused());
+  ImGui::End();
+}
+
+inline void drawStereoPanel(StereoRig &rig, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Display", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Checkbox("Side-by-side stereo", &rig.enabled);
+  if (rig.enabled)
+  {
+    float ipdMm = rig.ipd * 1000.0f;
+    if (ImGui::SliderFloat("IPD", &ipdMm, 50.0f, 75.0f, "%.1f mm"))
+      rig.ipd = ipdMm / 1000.0f;
+    ImGui::SliderFloat("Convergence", &rig.convergence, 0.1f, 2.0f, "%.2f m",
+                       ImGuiSliderFlags_Logarithmic);
+    ImGui::TextDisabled("(one instanced pass, both eyes)");
+  }
+  ImGui::End();
+}
+
+// Render scale of the 3-D layer; shares the "Display" window with stereo
+inline void drawResolutionPanel(DynamicResolution &dr, float gpuMs, int w, int h, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Display", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SeparatorText("3-D layer resolution");
+  ImGui::Checkbox("Dynamic", &dr.enabled);
+  if (dr.enabled)
+  {
+    ImGui::SliderFloat("GPU budget", &dr.targetMs, 2.0f, 33.0f, "%.1f ms");
+    ImGui::SliderFloat("Min scale", &dr.minScale, 0.25f, dr.maxScale, "%.2f");
+    ImGui::SliderFloat("Max scale", &dr.maxScale, dr.minScale, 1.0f, "%.2f");
+  }
+  else
+    ImGui::SliderFloat("Scale", &dr.scale, 0.25f, 1.0f, "%.2f");
+  ImGui::SliderFloat("Sharpness", &dr.sharpness, 0.0f, 1.0f, "%.2f");
+  ImGui::Text("%dx%d (%.0f%%)  GPU %.2f ms", static_cast<int>(w * dr.scale),
+              static_cast<int>(h * dr.scale), dr.scale * 100.0f, gpuMs);
+  ImGui::End();
+}
+
+// Detect-then-track controls and counters (cumulative since start)
+inline void drawTrackingPanel(TrackSettings &ts, const TrackStats &st, const QuadDetectorStats &qs,
+                              bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Tracking", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Checkbox("Optical flow between detections", &ts.enabled);
+  if (ts.enabled)
+  {
+    ImGui::SliderInt("Max interval", &ts.maxInterval, ts.minInterval, 30, "%d frames");
+    ImGui::SliderFloat("FB error", &ts.fbMaxPx, 0.1f, 3.0f, "%.2f px");
+    ImGui::SliderFloat("Fast motion", &ts.fastPx, ts.slowPx + 1.0f, 60.0f, "%.0f px/frame");
+  }
+  double full = st.frames ? 100.0 * st.detections / st.frames : 0.0;
+  ImGui::Text("Full detection: %.1f%% of frames (every %d)", full, st.interval);
+  ImGui::Text("Flow fallbacks: %ld   motion: %.1f px", st.fallbacks, st.motionPx);
+  ImGui::Checkbox("Fast candidate detection", &ts.fastDetect);
+  if (ts.fastDetect)
+    ImGui::Text("threshold %.2f  contours %.2f  decode %.2f ms\n%d contours, %d quads, %d markers",
+                qs.thresholdMs, qs.contourMs, qs.decodeMs, qs.contours, qs.quads, qs.markers);
+  ImGui::End();
+}
+
+inline void drawCameraPanel(FuseSettings &fs, const std::vector<StreamStats> &ss, bool *show = nullptr)
+{
+  if ((show && !*show) || ss.size() < 2)
+    return;
+  ImGui::Begin("Tracking", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SeparatorText("Cameras");
+  ImGui::Checkbox("Fuse marker poses", &fs.enabled);
+  if (fs.enabled)
+    ImGui::SliderFloat("Max pose age", &fs.maxAgeSec, 0.02f, 0.5f, "%.2f s");
+  for (const StreamStats &s : ss)
+  {
+    double seen = s.frames ? 100.0 * s.detections / s.frames : 0.0;
+    ImGui::Text("%-10s %5.1f fps  %5.1f ms  seen %5.1f%%  err %.2f px  weight %3.0f%%", s.name, s.fps,
+                s.latencyMs, seen, s.reprojErr, 100.0f * s.weight);
+  }
+  ImGui::End();
+}
+
+inline void drawTrailsPanel(Trails &trails, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Display", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SeparatorText("Orbit trails");
+  ImGui::Checkbox("Trails", &trails.enabled);
+  if (trails.enabled)
+  {
+    int len = trails.length();
+    if (ImGui::SliderInt("Length", &len, 16, 2048, "%d frames", ImGuiSliderFlags_Logarithmic))
+      trails.setLength(len);
+    ImGui::ColorEdit3("Colour", &trails.color[0], ImGuiColorEditFlags_NoInputs);
+    const TrailStats &ts = trails.stats();
+    ImGui::Text("%d trails, ring %.1f KB", ts.bodies, ts.bufferBytes / 1024.0);
+    ImGui::Text("Upload %.2f KB/frame (rebuild would be %.1f KB)", ts.uploadBytes / 1024.0,
+                ts.naiveBytes / 1024.0);
+  }
+  ImGui::End();
+}
+
+inline void drawBloomPanel(Bloom &bloom, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Display", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SeparatorText("Sun bloom");
+  ImGui::Checkbox("Bloom", &bloom.enabled);
+  if (bloom.enabled)
+  {
+    ImGui::SliderFloat("Strength", &bloom.strength, 0.0f, 3.0f, "%.2f");
+    ImGui::SliderFloat("Radius", &bloom.radius, 0.5f, 4.0f, "%.2f");
+  }
+  ImGui::End();
+}
+
+inline void drawVirtualTexturePanel(VirtualTextures &vt, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  const VirtualTextureStats s = vt.stats();
+  ImGui::Begin("Display", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SeparatorText("Virtual textures");
+  ImGui::Text("%d sources, %.1f MB GPU", s.sources, s.cacheBytes / 1048576.0);
+  ImGui::Text("Cache: %d / %d tiles (%d pinned)", s.resident, s.capacity, s.pinned);
+  ImGui::Text("Visible: %d  queued: %d  loading: %d", s.visible, s.queued, s.loading);
+  ImGui::Text("Uploads: %d this frame, %llu evictions", s.uploads, (unsigned long long)s.evictions);
+  ImGui::SliderInt("Uploads / frame", &vt.uploadBudget, 1, 32);
+  ImGui::SliderInt("Feedback divisor", &vt.feedbackDivisor, 2, 16);
+  ImGui::End();
+}
+
+inline void drawPublisherPanel(const FramePublisher &pub, bool &enabled, bool *show = nullptr)
+{
+  if (show && !*show)
+    return;
+  ImGui::Begin("Recording", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SeparatorText("Shared memory");
+  ImGui::Checkbox("Publish frames + pose", &enabled);
+  if (pub.isOpen())
+    ImGui::Text("%s: %llu frames, %.1f MB ring", pub.name().c_str(),
+                (unsigned long long)pub.published(), pub.bytes() / 1048576.0);
   ImGui::End();
 }
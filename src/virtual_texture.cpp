@@ -0,0 +1,521 @@
+#include "virtual_texture.hpp"
+#include "shader.hpp"
+#include "logger.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  constexpr int kMaxQueued = 64; // requests handed to the workers per frame
+}
+
+VirtualTextures::VirtualTextures(int cacheTiles, int workers)
+    : cacheTiles_(std::clamp(cacheTiles, 2, 256)), workerCount_(std::max(1, workers))
+{
+}
+
+VirtualTextures::~VirtualTextures()
+{
+  stopWorkers();
+  for (Source &s : sources_)
+    if (s.fd >= 0)
+      ::close(s.fd);
+}
+
+void VirtualTextures::startWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lk(loadMutex_);
+    quit_ = false;
+  }
+  for (int i = 0; i < workerCount_; ++i)
+    workers_.emplace_back(&VirtualTextures::workerLoop, this);
+}
+
+void VirtualTextures::stopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lk(loadMutex_);
+    quit_ = true;
+  }
+  loadCv_.notify_all();
+  for (std::thread &t : workers_)
+    if (t.joinable())
+      t.join();
+  workers_.clear();
+}
+
+void VirtualTextures::ensureCache()
+{
+  if (cacheTex_)
+    return;
+  const int px = cacheTiles_ * vtf::kPhysTile;
+  glGenTextures(1, &cacheTex_);
+  glBindTexture(GL_TEXTURE_2D, cacheTex_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, px, px, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  slots_.assign(std::size_t(cacheTiles_) * cacheTiles_, Slot{});
+  LOG_INF("Virtual texture cache: %dx%d tiles, %.1f MB", cacheTiles_, cacheTiles_,
+          px * double(px) * 4 / (1024.0 * 1024.0));
+}
+
+int VirtualTextures::open(const std::string &path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return -1;
+
+  Source src;
+  src.path = path;
+  src.fd = fd;
+  vtf::FileHeader &h = src.hdr;
+  auto bad = [&](const char *why)
+  {
+    LOG_ERR("Virtual texture %s: %s", path.c_str(), why);
+    ::close(fd);
+    return -1;
+  };
+  if (::pread(fd, &h, sizeof(h), 0) != ssize_t(sizeof(h)) || h.magic != vtf::kMagic)
+    return bad("not a tile pyramid");
+  if (h.version != vtf::kVersion || h.tileSize != std::uint32_t(vtf::kTileSize) ||
+      h.border != std::uint32_t(vtf::kBorder))
+    return bad("cooked with a different format version; re-run vt_cook");
+  if (!h.tilesX || !h.tilesY || h.tilesX > 256 || h.tilesY > 256 || (h.tilesX & (h.tilesX - 1)) ||
+      (h.tilesY & (h.tilesY - 1)))
+    return bad("bad tile counts");
+  std::uint32_t maxLevels = 1; // down to a single tile; also keeps keys' 8-bit level field honest
+  while (std::max(h.tilesX, h.tilesY) >> maxLevels)
+    ++maxLevels;
+  if (!h.levels || h.levels > maxLevels)
+    return bad("bad level count");
+
+  std::uint32_t entries = 0;
+  for (std::uint32_t l = 0; l < h.levels; ++l)
+  {
+    src.levelStart.push_back(entries);
+    entries += vtf::tilesAt(h.tilesX, l) * vtf::tilesAt(h.tilesY, l);
+  }
+  src.tableStart = src.levelStart; // one page-table texel per tile
+  src.index.resize(entries);
+  const ssize_t indexBytes = ssize_t(entries * sizeof(vtf::TileEntry));
+  if (::pread(fd, src.index.data(), indexBytes, sizeof(h)) != indexBytes)
+    return bad("truncated index");
+  src.table.assign(std::size_t(entries) * 4, 0);
+
+  ensureCache();
+  glGenTextures(1, &src.pageTex);
+  glBindTexture(GL_TEXTURE_2D, src.pageTex);
+  for (std::uint32_t l = 0; l < h.levels; ++l)
+    glTexImage2D(GL_TEXTURE_2D, GLint(l), GL_RGBA8, GLsizei(vtf::tilesAt(h.tilesX, l)),
+                 GLsizei(vtf::tilesAt(h.tilesY, l)), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(h.levels - 1));
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  const int id = int(sources_.size());
+  sources_.push_back(std::move(src));
+  if (workers_.empty())
+    startWorkers(); // only once there is something to stream
+
+  // The top level is the fallback for every tile: load it now and never evict it
+  const std::uint32_t top = h.levels - 1;
+  const int tx = int(vtf::tilesAt(h.tilesX, top)), ty = int(vtf::tilesAt(h.tilesY, top));
+  for (int y = 0; y < ty; ++y)
+    for (int x = 0; x < tx; ++x)
+    {
+      std::uint64_t key = makeKey(id, int(top), x, y);
+      cv::Mat rgb = loadTile(request(key));
+      if (rgb.empty() || !place(key, rgb, true))
+        LOG_ERR("Virtual texture %s: cannot make top tile %d,%d resident", path.c_str(), x, y);
+    }
+  rebuildPageTable(id);
+
+  LOG_INF("Virtual texture %s: %ux%u (%ux%u tiles, %u levels)", path.c_str(),
+          h.tilesX * vtf::kTileSize, h.tilesY * vtf::kTileSize, h.tilesX, h.tilesY, h.levels);
+  return id;
+}
+
+VirtualTextures::Request VirtualTextures::request(std::uint64_t key) const
+{
+  const Source &s = sources_[keyId(key)];
+  const int level = keyLevel(key);
+  const std::uint32_t tx = vtf::tilesAt(s.hdr.tilesX, std::uint32_t(level));
+  const vtf::TileEntry &e = s.index[s.levelStart[level] + std::uint32_t(keyY(key)) * tx + std::uint32_t(keyX(key))];
+  return {key, s.fd, e.offset, e.bytes};
+}
+
+cv::Mat VirtualTextures::loadTile(const Request &r)
+{
+  std::vector<unsigned char> blob(r.bytes);
+  if (::pread(r.fd, blob.data(), r.bytes, off_t(r.offset)) != ssize_t(r.bytes))
+    return {};
+  cv::Mat bgr = cv::imdecode(blob, cv::IMREAD_COLOR), rgb;
+  if (bgr.cols != vtf::kPhysTile || bgr.rows != vtf::kPhysTile)
+    return {};
+  cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+  return rgb;
+}
+
+void VirtualTextures::workerLoop()
+{
+  for (;;)
+  {
+    Request r;
+    {
+      std::unique_lock<std::mutex> lk(loadMutex_);
+      loadCv_.wait(lk, [this]
+                   { return quit_ || !queue_.empty(); });
+      if (quit_)
+        return;
+      r = queue_.back(); // coarsest first
+      queue_.pop_back();
+      ++loading_;
+    }
+
+    Loaded l{r.key, loadTile(r)}; // file read + JPEG decode, off the render thread
+    if (l.rgb.empty())
+      LOG_ERR("Virtual texture tile %d/%d,%d unreadable", keyLevel(r.key), keyX(r.key), keyY(r.key));
+
+    std::lock_guard<std::mutex> lk(loadMutex_);
+    --loading_;
+    done_.push_back(std::move(l));
+  }
+}
+
+void VirtualTextures::bindCache() const
+{
+  glActiveTexture(GL_TEXTURE0 + kCacheUnit);
+  glBindTexture(GL_TEXTURE_2D, cacheTex_);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+// ---- LRU ----
+
+void VirtualTextures::unlink(int s)
+{
+  Slot &sl = slots_[s];
+  (sl.prev >= 0 ? slots_[sl.prev].next : head_) = sl.next;
+  (sl.next >= 0 ? slots_[sl.next].prev : tail_) = sl.prev;
+  sl.prev = sl.next = -1;
+}
+
+void VirtualTextures::pushFront(int s)
+{
+  Slot &sl = slots_[s];
+  sl.prev = -1;
+  sl.next = head_;
+  (head_ >= 0 ? slots_[head_].prev : tail_) = s;
+  head_ = s;
+}
+
+void VirtualTextures::touch(int s)
+{
+  slots_[s].used = frame_;
+  if (slots_[s].pinned || head_ == s)
+    return;
+  unlink(s);
+  pushFront(s);
+}
+
+bool VirtualTextures::place(std::uint64_t key, const cv::Mat &rgb, bool pinned)
+{
+  const int n = int(slots_.size());
+  int s;
+  if (free_ < n)
+    s = free_++;
+  else
+  {
+    s = tail_;
+    if (s < 0 || slots_[s].used == frame_)
+      return false; // every evictable tile is on screen: keep what we have
+    unlink(s);
+    resident_.erase(slots_[s].key);
+    sources_[keyId(slots_[s].key)].dirty = true;
+    ++evictions_;
+  }
+
+  Slot &sl = slots_[s];
+  sl.key = key;
+  sl.used = frame_;
+  sl.pinned = pinned;
+  if (!pinned)
+    pushFront(s);
+  resident_[key] = s;
+  sources_[keyId(key)].dirty = true;
+
+  const int P = vtf::kPhysTile;
+  glBindTexture(GL_TEXTURE_2D, cacheTex_);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, (s % cacheTiles_) * P, (s / cacheTiles_) * P, P, P, GL_RGB,
+                  GL_UNSIGNED_BYTE, rgb.data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return true;
+}
+
+void VirtualTextures::rebuildPageTable(int id)
+{
+  Source &src = sources_[id];
+  const vtf::FileHeader &h = src.hdr;
+  std::fill(src.table.begin(), src.table.end(), 0);
+
+  // Resident tiles map to themselves ...
+  for (const auto &[key, s] : resident_)
+  {
+    if (keyId(key) != id)
+      continue;
+    const int level = keyLevel(key);
+    const std::uint32_t tx = vtf::tilesAt(h.tilesX, std::uint32_t(level));
+    std::uint8_t *e = &src.table[4 * (src.tableStart[level] + std::uint32_t(keyY(key)) * tx + std::uint32_t(keyX(key)))];
+    e[0] = std::uint8_t(s % cacheTiles_);
+    e[1] = std::uint8_t(s / cacheTiles_);
+    e[2] = std::uint8_t(level);
+    e[3] = std::uint8_t(id + 1);
+  }
+  // ... everything else inherits its parent's entry, coarse to fine
+  for (int level = int(h.levels) - 2; level >= 0; --level)
+  {
+    const std::uint32_t tx = vtf::tilesAt(h.tilesX, std::uint32_t(level)), ty = vtf::tilesAt(h.tilesY, std::uint32_t(level));
+    const std::uint32_t ptx = vtf::tilesAt(h.tilesX, std::uint32_t(level + 1));
+    const std::uint8_t *parent = &src.table[4 * src.tableStart[level + 1]];
+    std::uint8_t *row = &src.table[4 * src.tableStart[level]];
+    for (std::uint32_t y = 0; y < ty; ++y)
+      for (std::uint32_t x = 0; x < tx; ++x)
+      {
+        std::uint8_t *e = row + 4 * (y * tx + x);
+        if (!e[3])
+          std::copy_n(parent + 4 * ((y / 2) * ptx + x / 2), 4, e);
+      }
+  }
+
+  glBindTexture(GL_TEXTURE_2D, src.pageTex);
+  for (std::uint32_t l = 0; l < h.levels; ++l)
+    glTexSubImage2D(GL_TEXTURE_2D, GLint(l), 0, 0, GLsizei(vtf::tilesAt(h.tilesX, l)),
+                    GLsizei(vtf::tilesAt(h.tilesY, l)), GL_RGBA, GL_UNSIGNED_BYTE,
+                    &src.table[4 * src.tableStart[l]]);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  src.dirty = false;
+}
+
+// ---- per frame ----
+
+void VirtualTextures::update()
+{
+  ++frame_;
+  uploads_ = 0;
+  if (sources_.empty())
+    return;
+  if (fresh_)
+    queueMissing();
+  uploadLoaded();
+  for (int id = 0; id < int(sources_.size()); ++id)
+    if (sources_[id].dirty)
+      rebuildPageTable(id);
+}
+
+void VirtualTextures::queueMissing()
+{
+  fresh_ = false;
+
+  // Requests nobody has started are dropped; still-visible ones come back below
+  {
+    std::lock_guard<std::mutex> lk(loadMutex_);
+    for (const Request &r : queue_)
+      inFlight_.erase(r.key);
+    queue_.clear();
+  }
+
+  nextQueue_.clear();
+  for (std::uint64_t key : wanted_)
+  {
+    // Walk up to the first resident ancestor (what is on screen now),
+    // requesting every missing level on the way
+    const int id = keyId(key);
+    const int top = int(sources_[id].hdr.levels) - 1;
+    for (int level = keyLevel(key), x = keyX(key), y = keyY(key); level <= top; ++level, x /= 2, y /= 2)
+    {
+      std::uint64_t k = makeKey(id, level, x, y);
+      auto it = resident_.find(k);
+      if (it != resident_.end())
+      {
+        touch(it->second);
+        break;
+      }
+      if (inFlight_.insert(k).second)
+        nextQueue_.push_back(request(k));
+    }
+  }
+
+  // Workers pop from the back: coarsest last in the vector, and only the
+  // kMaxQueued most urgent survive
+  std::sort(nextQueue_.begin(), nextQueue_.end(), [](const Request &a, const Request &b)
+            { return keyLevel(a.key) < keyLevel(b.key); });
+  if (int(nextQueue_.size()) > kMaxQueued)
+  {
+    const auto cut = nextQueue_.end() - kMaxQueued;
+    for (auto it = nextQueue_.begin(); it != cut; ++it)
+      inFlight_.erase(it->key);
+    nextQueue_.erase(nextQueue_.begin(), cut);
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(loadMutex_);
+    queue_.swap(nextQueue_);
+  }
+  loadCv_.notify_all();
+}
+
+void VirtualTextures::uploadLoaded()
+{
+  {
+    std::lock_guard<std::mutex> lk(loadMutex_);
+    const int n = std::min(int(done_.size()), std::max(0, uploadBudget));
+    for (int i = 0; i < n; ++i)
+      uploading_.push_back(std::move(done_[i]));
+    done_.erase(done_.begin(), done_.begin() + n);
+  }
+
+  for (const Loaded &l : uploading_)
+  {
+    inFlight_.erase(l.key);
+    if (l.rgb.empty() || resident_.count(l.key))
+      continue;
+    if (place(l.key, l.rgb, false))
+      ++uploads_;
+  }
+  uploading_.clear();
+}
+
+void VirtualTextures::beginFeedback(const Shader &sh, int w, int h)
+{
+  const int div = std::max(1, feedbackDivisor);
+  fbW_ = std::max(1, w / div);
+  fbH_ = std::max(1, h / div);
+  feedback_.ensure(fbW_, fbH_);
+  feedback_.bind(fbW_, fbH_);
+  glClearColor(0, 0, 0, 0); // alpha 0: no virtual texture here
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // Derivatives are `div` times larger at this size than on screen
+  glProgramUniform1f(sh.id(), sh.uniform("uLodBias"), -std::log2(float(div)));
+}
+
+void VirtualTextures::endFeedback()
+{
+  if (!pbos_[0])
+    glGenBuffers(kPbos, pbos_);
+
+  // This PBO was filled kPbos frames ago; its transfer is long done
+  if (pboPending_[pboHead_])
+    readFeedback(pboHead_);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, feedback_.fbo());
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[pboHead_]);
+  if (pboW_[pboHead_] != fbW_ || pboH_[pboHead_] != fbH_)
+  {
+    glBufferData(GL_PIXEL_PACK_BUFFER, std::size_t(fbW_) * fbH_ * 4, nullptr, GL_STREAM_READ);
+    pboW_[pboHead_] = fbW_;
+    pboH_[pboHead_] = fbH_;
+  }
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, fbW_, fbH_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // async into PBO
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  pboPending_[pboHead_] = true;
+  pboHead_ = (pboHead_ + 1) % kPbos;
+}
+
+void VirtualTextures::readFeedback(int pbo)
+{
+  pboPending_[pbo] = false;
+  const std::size_t bytes = std::size_t(pboW_[pbo]) * pboH_[pbo] * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[pbo]);
+  const auto *px = static_cast<const std::uint8_t *>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+  if (!px)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return;
+  }
+
+  wanted_.clear();
+  std::uint64_t last = ~0ull; // neighbouring pixels mostly repeat
+  for (std::size_t i = 0; i < bytes; i += 4)
+  {
+    const int id = px[i + 3] - 1;
+    if (id < 0 || id >= int(sources_.size()))
+      continue;
+    std::uint64_t k = makeKey(id, px[i + 2], px[i], px[i + 1]);
+    if (k != last)
+      wanted_.push_back(last = k);
+  }
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  std::sort(wanted_.begin(), wanted_.end());
+  wanted_.erase(std::unique(wanted_.begin(), wanted_.end()), wanted_.end());
+  visible_ = int(wanted_.size());
+  fresh_ = true;
+}
+
+VirtualTextureStats VirtualTextures::stats() const
+{
+  VirtualTextureStats s;
+  s.sources = int(sources_.size());
+  s.capacity = int(slots_.size());
+  s.resident = int(resident_.size());
+  for (const Slot &sl : slots_)
+    s.pinned += sl.pinned;
+  s.visible = visible_;
+  s.uploads = uploads_;
+  s.evictions = evictions_;
+  if (cacheTex_)
+    s.cacheBytes = std::size_t(cacheTiles_ * vtf::kPhysTile) * (cacheTiles_ * vtf::kPhysTile) * 4;
+  for (const Source &src : sources_)
+    s.cacheBytes += src.table.size(); // page table, every level already included
+  std::lock_guard<std::mutex> lk(loadMutex_);
+  s.queued = int(queue_.size());
+  s.loading = loading_;
+  return s;
+}
+
+void VirtualTextures::destroy()
+{
+  stopWorkers();
+  for (Source &s : sources_)
+  {
+    if (s.pageTex)
+      glDeleteTextures(1, &s.pageTex);
+    if (s.fd >= 0)
+      ::close(s.fd);
+  }
+  sources_.clear();
+  if (cacheTex_)
+    glDeleteTextures(1, &cacheTex_);
+  if (pbos_[0])
+    glDeleteBuffers(kPbos, pbos_);
+  for (int i = 0; i < kPbos; ++i)
+  {
+    pbos_[i] = 0;
+    pboPending_[i] = false;
+    pboW_[i] = pboH_[i] = 0;
+  }
+  cacheTex_ = 0;
+  feedback_.destroy();
+  slots_.clear();
+  resident_.clear();
+  inFlight_.clear();
+  head_ = tail_ = -1;
+  free_ = 0;
+}
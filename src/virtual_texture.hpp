@@ -0,0 +1,169 @@
+#pragma once
+#include "render_target.hpp"
+#include "vt_format.hpp"
+#include <opencv2/core.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Shader;
+
+struct VirtualTextureStats
+{
+  int sources{0};
+  int resident{0}, capacity{0}, pinned{0}; // cache tiles
+  int visible{0};                          // distinct tiles in the last feedback
+  int queued{0}, loading{0};               // waiting for / inside a worker
+  int uploads{0};                          // last frame
+  std::uint64_t evictions{0};
+  std::size_t cacheBytes{0};               // fixed: physical cache + page tables
+};
+
+// Virtual texturing for planet surfaces too large to load whole.
+// Each source is a tile pyramid cooked by cook/vt_cook. One physical tile
+// cache texture, shared by every source, holds the resident tiles; each
+// source has a small mipmapped page table (RGBA8: cache x, cache y, level
+// actually resident, source id + 1) that maps every virtual tile to itself
+// or its nearest resident ancestor. The coarsest level of every source is
+// pinned, so a lookup always lands on something.
+//
+// Once per frame:
+//   update()                   read back an earlier feedback frame, queue the
+//                              missing tiles (coarse first) for the worker
+//                              threads, upload at most uploadBudget decoded
+//                              tiles into LRU slots, rebuild changed page tables
+//   beginFeedback / endFeedback  draw the textured bodies with VT_FEEDBACK_FSHADER
+//                              into a small target; read back through PBOs, so
+//                              the CPU never waits for it
+//
+// GPU memory is fixed by the cache size, whatever the source resolution.
+// Render thread only, except for the loader threads it owns.
+class VirtualTextures
+{
+public:
+  static constexpr int kCacheUnit = 1; // texture unit the cache is sampled from
+
+  explicit VirtualTextures(int cacheTiles = 16, int workers = 2);
+  ~VirtualTextures();
+  VirtualTextures(const VirtualTextures &) = delete;
+  VirtualTextures &operator=(const VirtualTextures &) = delete;
+
+  // Opens a cooked .vt file; -1 if missing or invalid. Loads and pins its top
+  // level. The loader threads start with the first file opened.
+  int open(const std::string &path);
+  bool active() const { return !sources_.empty(); }
+  GLuint pageTable(int id) const { return sources_[id].pageTex; }
+  GLuint cache() const { return cacheTex_; }
+  void bindCache() const; // on kCacheUnit, leaves unit 0 active
+
+  void update();
+  // Feedback at 1/feedbackDivisor of (w, h); sh is the VT_FEEDBACK_FSHADER program
+  void beginFeedback(const Shader &sh, int w, int h);
+  void endFeedback();
+  void destroy(); // GL objects and threads; call while the context is current
+
+  VirtualTextureStats stats() const;
+
+  int uploadBudget = 8;    // tiles per frame
+  int feedbackDivisor = 8;
+
+private:
+  struct Source
+  {
+    std::string path;
+    int fd{-1};
+    vtf::FileHeader hdr{};
+    std::vector<vtf::TileEntry> index;
+    std::vector<std::uint32_t> levelStart; // first index entry of each level
+    std::vector<std::uint8_t> table;       // CPU page table, all levels, RGBA8
+    std::vector<std::uint32_t> tableStart; // first texel of each level in `table`
+    GLuint pageTex{};
+    bool dirty{true};
+  };
+  struct Request
+  {
+    std::uint64_t key;
+    int fd;
+    std::uint64_t offset;
+    std::uint32_t bytes;
+  };
+  struct Loaded
+  {
+    std::uint64_t key;
+    cv::Mat rgb; // kPhysTile square, or empty on a read/decode failure
+  };
+
+  static std::uint64_t makeKey(int id, int level, int x, int y)
+  {
+    return std::uint64_t(id) << 48 | std::uint64_t(level) << 40 | std::uint64_t(y) << 20 | std::uint64_t(x);
+  }
+  static int keyId(std::uint64_t k) { return int(k >> 48); }
+  static int keyLevel(std::uint64_t k) { return int(k >> 40 & 0xff); }
+  static int keyY(std::uint64_t k) { return int(k >> 20 & 0xfffff); }
+  static int keyX(std::uint64_t k) { return int(k & 0xfffff); }
+
+  Request request(std::uint64_t key) const;
+  void readFeedback(int pbo);
+  void queueMissing();
+  void uploadLoaded();
+  bool place(std::uint64_t key, const cv::Mat &rgb, bool pinned);
+  void rebuildPageTable(int id);
+  void workerLoop();
+  void startWorkers();
+  void stopWorkers();
+  void ensureCache();
+  static cv::Mat loadTile(const Request &r);
+
+  // LRU over unpinned slots: head_ most recently used
+  void touch(int slot);
+  void unlink(int slot);
+  void pushFront(int slot);
+
+  std::vector<Source> sources_;
+
+  // Physical cache
+  int cacheTiles_;
+  GLuint cacheTex_{};
+  struct Slot
+  {
+    std::uint64_t key{~0ull};
+    std::uint64_t used{0}; // frame last seen in feedback
+    int prev{-1}, next{-1};
+    bool pinned{false};
+  };
+  std::vector<Slot> slots_;
+  int head_{-1}, tail_{-1}, free_{0}; // slots [free_, N) never used yet
+  std::unordered_map<std::uint64_t, int> resident_;
+  std::uint64_t frame_{0};
+
+  // Feedback
+  RenderTarget feedback_{1, true};
+  static constexpr int kPbos = 3;
+  GLuint pbos_[kPbos]{};
+  int pboW_[kPbos]{}, pboH_[kPbos]{};
+  bool pboPending_[kPbos]{};
+  int pboHead_{0}, fbW_{0}, fbH_{0};
+  std::vector<std::uint64_t> wanted_; // distinct visible tiles, scratch
+  bool fresh_{false};                 // wanted_ not yet turned into requests
+
+  // Loader: queue_ is replaced every frame (stale requests dropped), served
+  // from the back, which holds the coarsest tiles
+  int workerCount_;
+  std::vector<std::thread> workers_;
+  mutable std::mutex loadMutex_;
+  std::condition_variable loadCv_;
+  std::vector<Request> queue_, nextQueue_;
+  std::vector<Loaded> done_, uploading_;
+  int loading_{0};
+  bool quit_{false};
+  std::unordered_set<std::uint64_t> inFlight_; // render thread: queued, loading or done
+
+  int uploads_{0};
+  std::uint64_t evictions_{0};
+  int visible_{0};
+};
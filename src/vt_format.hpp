@@ -0,0 +1,46 @@
+#pragma once
+// Tile-pyramid file for virtual textures: written by cook/vt_cook, read by
+// VirtualTextures. Shared layout, no dependencies.
+//
+//   FileHeader
+//   TileEntry[sum over levels of tilesX(l) * tilesY(l)]   level-major, rows bottom-up
+//   tile blobs                                             JPEG, kPhysTile x kPhysTile
+//
+// Level 0 is tilesX x tilesY tiles of kTileSize texels, both powers of two;
+// level l has (tilesX >> l) x (tilesY >> l), down to a single tile row or
+// column. Each stored tile carries kBorder texels of its neighbours on every
+// side (wrapping in u, clamped in v: equirectangular maps) so bilinear
+// filtering never reads another tile. Rows are stored bottom-up, the way GL
+// (and Texture, which flips on load) addresses them.
+
+#include <cstdint>
+
+namespace vtf
+{
+  constexpr std::uint32_t kMagic = 0x31545653; // "SVT1"
+  constexpr std::uint32_t kVersion = 1;
+  constexpr int kTileSize = 128;                    // payload texels per side
+  constexpr int kBorder = 4;                        // filter margin per side
+  constexpr int kPhysTile = kTileSize + 2 * kBorder; // stored / cached tile size
+
+  struct FileHeader
+  {
+    std::uint32_t magic, version;
+    std::uint32_t tilesX, tilesY; // level 0
+    std::uint32_t levels;
+    std::uint32_t tileSize, border; // must match kTileSize / kBorder
+    std::uint32_t reserved;
+  };
+
+  struct TileEntry
+  {
+    std::uint64_t offset; // from the start of the file
+    std::uint32_t bytes;
+    std::uint32_t reserved;
+  };
+
+  inline std::uint32_t tilesAt(std::uint32_t tiles0, std::uint32_t level)
+  {
+    return tiles0 >> level ? tiles0 >> level : 1;
+  }
+}